@@ -12,6 +12,8 @@
 #include <fmt/format.h>
 #include <nlohmann/json.hpp>
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <optional>
@@ -36,6 +38,7 @@ namespace
 } // anonymous namespace
 
 auto print_usage_info() -> void;
+auto print_stats(DataObjInp& _input) -> int;
 
 int main(int _argc, char* _argv[]) // NOLINT(modernize-use-trailing-return-type)
 {
@@ -51,6 +54,21 @@ int main(int _argc, char* _argv[]) // NOLINT(modernize-use-trailing-return-type)
 		("resource,R", po::value<std::string>(), "")
 		("replica-number,n", po::value<int>(), "")
 		("admin-mode,M", po::value<bool>()->default_value(false), "")
+		("collection,C", po::bool_switch(), "")
+		("manifest", po::bool_switch(), "")
+		("name-like", po::value<std::string>(), "")
+		("only-if-larger", po::bool_switch(), "")
+		("defer-notifications", po::bool_switch(), "")
+		("priority", po::value<std::string>(), "")
+		("stats", po::bool_switch(), "")
+		("reset-ledger", po::bool_switch(), "")
+		("wait", po::value<int>(), "")
+		("prefer-local", po::bool_switch(), "")
+		("deadline", po::value<int>(), "")
+		("allow-copy", po::bool_switch(), "")
+		("request-id", po::value<std::string>(), "")
+		("to-delimiter", po::value<std::string>(), "")
+		("snapshot", po::value<std::string>(), "")
 		("logical_path", po::value<std::string>(), "") // positional option
 		("help,h", "");
 	// clang-format on
@@ -73,6 +91,21 @@ int main(int _argc, char* _argv[]) // NOLINT(modernize-use-trailing-return-type)
 		DataObjInp input{};
 		auto cond_input = irods::experimental::make_key_value_proxy(input.condInput);
 
+		if (vm["stats"].as<bool>()) {
+			cond_input[TRUNCATE_STATS_KW] = "";
+
+			if (vm["reset-ledger"].as<bool>()) {
+				cond_input[TRUNCATE_RESET_LEDGER_KW] = "";
+			}
+
+			return print_stats(input);
+		}
+
+		if (vm["reset-ledger"].as<bool>()) {
+			fmt::print(stderr, "error: --reset-ledger requires --stats.\n");
+			return 1;
+		}
+
 		if (vm.count("logical_path") == 0) {
 			fmt::print(stderr, "error: Missing LOGICAL_PATH.\n");
 			return 1;
@@ -100,12 +133,26 @@ int main(int _argc, char* _argv[]) // NOLINT(modernize-use-trailing-return-type)
 			return 1;
 		}
 
-		if (vm.count("size") == 0) {
-			fmt::print(stderr, "error: Missing --size parameter.\n");
+		const bool manifest = vm["manifest"].as<bool>();
+
+		if (manifest && vm["collection"].as<bool>()) {
+			fmt::print(stderr, "error: --manifest and --collection options are incompatible.\n");
 			return 1;
 		}
 
-		input.dataSize = vm["size"].as<rodsLong_t>();
+		if (manifest) {
+			cond_input[TRUNCATE_MANIFEST_KW] = "";
+
+			// Entries of the manifest without a size of their own use this one, if there is one.
+			input.dataSize = vm.count("size") ? vm["size"].as<rodsLong_t>() : -1;
+		}
+		else if (vm.count("size") == 0) {
+			fmt::print(stderr, "error: Missing --size parameter.\n");
+			return 1;
+		}
+		else {
+			input.dataSize = vm["size"].as<rodsLong_t>();
+		}
 
 		if (vm.count("admin-mode") && vm["admin-mode"].as<bool>()) {
 			cond_input[ADMIN_KW] = "";
@@ -127,6 +174,103 @@ int main(int _argc, char* _argv[]) // NOLINT(modernize-use-trailing-return-type)
 			cond_input[REPL_NUM_KW] = std::to_string(vm["replica-number"].as<int>());
 		}
 
+		if (vm["collection"].as<bool>()) {
+			cond_input[TRUNCATE_COLLECTION_KW] = "";
+
+			if (vm.count("name-like")) {
+				cond_input[TRUNCATE_NAME_LIKE_KW] = vm["name-like"].as<std::string>();
+			}
+
+			if (vm["only-if-larger"].as<bool>()) {
+				cond_input[TRUNCATE_ONLY_IF_LARGER_KW] = "";
+			}
+		}
+		else if (vm.count("name-like") || vm["only-if-larger"].as<bool>()) {
+			fmt::print(stderr, "error: --name-like and --only-if-larger require --collection.\n");
+			return 1;
+		}
+
+		if (vm["defer-notifications"].as<bool>()) {
+			if (!vm["collection"].as<bool>() && !manifest) {
+				fmt::print(stderr, "error: --defer-notifications requires --collection or --manifest.\n");
+				return 1;
+			}
+
+			cond_input[TRUNCATE_DEFER_NOTIFICATIONS_KW] = "";
+		}
+
+		if (vm["prefer-local"].as<bool>()) {
+			if (resource_option_used || replica_number_option_used) {
+				fmt::print(stderr, "error: --prefer-local is incompatible with --resource and --replica-number.\n");
+				return 1;
+			}
+
+			cond_input[TRUNCATE_REPLICA_SELECTION_KW] = "local";
+		}
+
+		if (vm.count("deadline")) {
+			const auto deadline =
+				std::chrono::system_clock::now() + std::chrono::milliseconds{vm["deadline"].as<int>()};
+			cond_input[TRUNCATE_DEADLINE_KW] = std::to_string(
+				std::chrono::duration_cast<std::chrono::milliseconds>(deadline.time_since_epoch()).count());
+		}
+
+		if (vm["allow-copy"].as<bool>()) {
+			cond_input[TRUNCATE_ALLOW_COPY_KW] = "";
+		}
+
+		if (vm.count("to-delimiter")) {
+			auto delimiter = vm["to-delimiter"].as<std::string>();
+
+			// Shells make it awkward to pass control characters, so accept the usual escapes.
+			if ("\\n" == delimiter) {
+				delimiter = "\n";
+			}
+			else if ("\\t" == delimiter) {
+				delimiter = "\t";
+			}
+			else if ("\\r" == delimiter) {
+				delimiter = "\r";
+			}
+
+			if (1 != delimiter.size()) {
+				fmt::print(stderr, "error: --to-delimiter must be a single character.\n");
+				return 1;
+			}
+
+			cond_input[TRUNCATE_TO_DELIMITER_KW] = delimiter;
+		}
+
+		if (vm.count("snapshot")) {
+			const auto& mode = vm["snapshot"].as<std::string>();
+
+			if ("clone" != mode && "clone_or_copy" != mode) {
+				fmt::print(stderr, "error: --snapshot must be 'clone' or 'clone_or_copy'.\n");
+				return 1;
+			}
+
+			cond_input[TRUNCATE_SNAPSHOT_KW] = mode;
+		}
+
+		if (vm.count("request-id")) {
+			cond_input[TRUNCATE_REQUEST_ID_KW] = vm["request-id"].as<std::string>();
+		}
+
+		if (vm.count("wait")) {
+			cond_input[TRUNCATE_WAIT_FOR_AT_REST_KW] = std::to_string(vm["wait"].as<int>());
+		}
+
+		if (vm.count("priority")) {
+			const auto& priority = vm["priority"].as<std::string>();
+
+			if ("bulk" != priority && "interactive" != priority) {
+				fmt::print(stderr, "error: --priority must be 'bulk' or 'interactive'.\n");
+				return 1;
+			}
+
+			cond_input[TRUNCATE_PRIORITY_KW] = priority;
+		}
+
 		irods::experimental::client_connection conn;
 
 		BytesBuf* output{};
@@ -142,8 +286,56 @@ int main(int _argc, char* _argv[]) // NOLINT(modernize-use-trailing-return-type)
 
 		if (output && output->len > 0) {
 			const auto* output_str = static_cast<char*>(output->buf);
-			const auto& message = nlohmann::json::parse(output_str).at("message").get<const std::string>();
-			fmt::print(stdout, "{}\n", message);
+			const auto output_json = nlohmann::json::parse(output_str);
+
+			if (const auto& message = output_json.at("message").get_ref<const std::string&>(); !message.empty()) {
+				fmt::print(stdout, "{}\n", message);
+			}
+
+			if (const auto size = output_json.find("size"); size != output_json.end()) {
+				fmt::print(stdout, "size: {}\n", size->get<rodsLong_t>());
+			}
+
+			if (const auto snapshot = output_json.find("snapshot"); snapshot != output_json.end()) {
+				fmt::print(stdout,
+				           "snapshot ({}): {} in {}\n",
+				           snapshot->at("method").get_ref<const std::string&>(),
+				           snapshot->at("physical_path").get_ref<const std::string&>(),
+				           snapshot->at("resource_hierarchy").get_ref<const std::string&>());
+			}
+
+			if (output_json.value("replayed", false)) {
+				fmt::print(stdout, "Returned the result of an earlier attempt with the same request ID.\n");
+			}
+
+			if (const auto summary = output_json.find("summary"); summary != output_json.end()) {
+				fmt::print(stdout,
+				           "matched: {}, truncated: {}, skipped: {}, failed: {}\n",
+				           summary->at("matched").get<std::uint64_t>(),
+				           summary->at("truncated").get<std::uint64_t>(),
+				           summary->at("skipped").get<std::uint64_t>(),
+				           summary->at("failed").get<std::uint64_t>());
+
+				for (const auto& failure : output_json.at("failures")) {
+					fmt::print(stderr,
+					           "error: [{}]: {} {}\n",
+					           failure.at("path").get_ref<const std::string&>(),
+					           failure.at("error_code").get<int>(),
+					           failure.at("message").get_ref<const std::string&>());
+				}
+
+				if (output_json.at("failures_truncated").get<bool>()) {
+					fmt::print(stderr, "error: Some failures were not listed.\n");
+				}
+
+				if (const auto n = output_json.find("notifications"); n != output_json.end()) {
+					fmt::print(stdout,
+					           "notifications deferred: {}, delivered: {}, failed: {}\n",
+					           n->at("deferred").get<std::uint64_t>(),
+					           n->at("delivered").get<std::uint64_t>(),
+					           n->at("failed").get<std::uint64_t>());
+				}
+			}
 		}
 
 		if (ec != 0) {
@@ -171,7 +363,8 @@ Usage: itruncate [OPTIONS]... LOGICAL_PATH
 
 Truncates a replica of the specified data object at LOGICAL_PATH to the specified size in bytes.
 
-LOGICAL_PATH must refer to an existing, at-rest data object.
+LOGICAL_PATH must refer to an existing, at-rest data object, to a collection if -C is used, or to a
+manifest if --manifest is used.
 
 Options:
   -s, --size=SIZE_IN_BYTES
@@ -187,6 +380,77 @@ Options:
   -M, --admin-mode
 		If specified, execute with elevated privileges. Can only be used by rodsadmins.
 
+  -C, --collection
+		Treat LOGICAL_PATH as a collection and truncate every data object under it.
+		The server walks the catalog, so no listing is sent to the client.
+
+  --manifest
+		Treat LOGICAL_PATH as a data object listing the data objects to truncate,
+		one JSON object per line:
+		  {"path": "/zone/home/alice/a.log", "size": 0, "replica_number": 1}
+		"size" defaults to SIZE_IN_BYTES, which is optional with --manifest.
+		"replica_number" or "resource" may select the replica of each entry. The
+		server reads the manifest as it goes, so it may list millions of entries.
+
+  --name-like=PATTERN
+		With -C, only truncate data objects whose names match the GenQuery LIKE
+		PATTERN (e.g. '%.log').
+
+  --only-if-larger
+		With -C, only truncate data objects larger than SIZE_IN_BYTES.
+
+  --defer-notifications
+		With -C or --manifest, fire the fileModified policy once per truncated
+		replica after every data object is done, instead of after each one.
+
+  --priority=PRIORITY
+		Either 'interactive' or 'bulk'. Bulk requests yield to interactive ones when
+		the server limits truncates on a resource. Defaults to 'bulk' with -C and
+		--manifest, and 'interactive' otherwise.
+
+  --prefer-local
+		Let the server choose the replica, preferring one stored on the server which
+		handles the request. Incompatible with -R and -n.
+
+  --deadline=MILLISECONDS
+		Give the server MILLISECONDS to finish. Once that has passed, the server
+		stops before starting any further expensive work.
+
+  --allow-copy
+		If the resource cannot truncate natively, let the server truncate by copying
+		the data which is kept into a new file on the storage host. This can be slow
+		for large replicas.
+
+  --to-delimiter=CHAR
+		Treat SIZE_IN_BYTES as a maximum, and keep only the complete records which
+		end at or below it. Each record ends with CHAR, which may also be given as
+		'\n', '\t', or '\r'. The server finds the boundary on the storage host and
+		prints the size it chose.
+
+  --snapshot=MODE
+		Preserve the data in a file next to the replica before truncating it.
+		MODE is 'clone', which makes a copy-on-write clone and fails if the
+		storage cannot clone, or 'clone_or_copy', which copies the data instead
+		in that case. The location of the snapshot is printed.
+
+  --request-id=ID
+		Identify this request with ID (at most 64 characters). If the command is
+		run again with the same ID, options, and LOGICAL_PATH after it succeeded,
+		the server returns the earlier result instead of truncating again. Makes
+		retrying after a dropped connection safe.
+
+  --wait=MILLISECONDS
+		If the replica is in use, wait up to MILLISECONDS for it to come to rest
+		instead of failing immediately. The server may cap the wait.
+
+  --stats
+		Print the server's counters as JSON instead of truncating anything.
+		LOGICAL_PATH is not required. Can only be used by rodsadmins.
+
+  --reset-ledger
+		With --stats, empty the server's usage ledger after printing it. Use this
+		right after a full quota recalculation.
+
   -h, --help
 		Display this help message and exit.
 )_");
@@ -194,3 +458,37 @@ Options:
 	char name[] = "itruncate";
 	printReleaseInfo(name);
 } // print_usage_info
+
+auto print_stats(DataObjInp& _input) -> int
+{
+	irods::experimental::client_connection conn;
+
+	BytesBuf* output{};
+	irods::at_scope_exit free_output{[&output] { clearBytesBuffer(output); }};
+
+	const auto ec = procApiRequest(static_cast<RcComm*>(conn),
+	                               APN_REPLICA_TRUNCATE,
+	                               &_input,
+	                               nullptr,
+	                               reinterpret_cast<void**>(&output), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+	                               nullptr);
+
+	if (output && output->len > 0) {
+		auto output_json = nlohmann::json::parse(static_cast<char*>(output->buf));
+
+		if (ec != 0) {
+			fmt::print(stderr, "error: {}\n", output_json.at("message").get_ref<const std::string&>());
+		}
+		else {
+			output_json.erase("message");
+			fmt::print(stdout, "{}\n", output_json.dump(4));
+		}
+	}
+
+	if (ec != 0) {
+		fmt::print(stderr, "error: {}\n", ec);
+		return 1;
+	}
+
+	return 0;
+} // print_stats
@@ -0,0 +1,87 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_ADMISSION_CONTROL_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_ADMISSION_CONTROL_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace irods::replica_truncate
+{
+	class deadline;
+
+	namespace detail
+	{
+		struct admission_state;
+	} // namespace detail
+
+	/// \brief The lane a request is admitted through. Interactive requests are always admitted ahead of bulk ones.
+	enum class priority
+	{
+		interactive,
+		bulk
+	};
+
+	/// \brief Parse the value of TRUNCATE_PRIORITY_KW. Anything other than "bulk" is interactive.
+	auto to_priority(std::string_view _value) noexcept -> priority;
+
+	/// \brief Admission to the physical truncate and catalog update for one resource, held for as long as it exists.
+	///
+	/// Limits are configured per resource in the "admission_control" section of the plugin configuration. The most
+	/// specific resource in the hierarchy which has limits configured governs admission. If no resource in the
+	/// hierarchy has limits, admission is granted immediately.
+	///
+	/// Limits are shared by every agent on this server.
+	class admission_permit
+	{
+	  public:
+		/// \brief Wait until a truncate in \p _hierarchy may proceed, or until the configured maximum wait elapses.
+		///
+		/// The wait also ends once \p _deadline passes. Waiting for a free queue slot counts towards the wait. If the
+		/// limits cannot be enforced at all, the request is not admitted.
+		admission_permit(std::string_view _hierarchy, priority _priority, const deadline& _deadline);
+
+		admission_permit(const admission_permit&) = delete;
+		auto operator=(const admission_permit&) -> admission_permit& = delete;
+
+		~admission_permit();
+
+		/// \brief Whether the truncate may proceed.
+		auto admitted() const noexcept -> bool
+		{
+			return admitted_;
+		}
+
+		/// \brief The resource whose limits governed admission. Empty if none did.
+		auto resource() const noexcept -> const std::string&
+		{
+			return resource_;
+		}
+
+		/// \brief How long the request waited to be admitted (or rejected).
+		auto queue_delay() const noexcept -> std::chrono::microseconds
+		{
+			return queue_delay_;
+		}
+
+	  private:
+		detail::admission_state* state_{};
+		std::size_t entry_index_{};
+		bool admitted_{};
+		std::string resource_;
+		std::chrono::microseconds queue_delay_{};
+	}; // class admission_permit
+
+	/// \brief Counters for every resource under admission control on this server.
+	///
+	/// \return A JSON object mapping resource names to objects with "active" and "waiting" counts and per-lane
+	/// "admitted", "timed_out", "total_queue_delay_us", and "max_queue_delay_us" counters.
+	auto admission_statistics() -> nlohmann::json;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_ADMISSION_CONTROL_HPP
@@ -0,0 +1,84 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_BATCH_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_BATCH_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h> // For rodsLong_t.
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Forward declarations.
+struct RsComm;
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	class deferred_notifications;
+
+	/// \brief One data object of a request which truncates many of them.
+	struct batch_entry
+	{
+		std::string_view logical_path;
+		rodsLong_t size;
+
+		// Overrides the replica selection of the request, if set. At most one of these is set.
+		std::optional<int> replica_number;
+		std::string_view resource;
+	}; // struct batch_entry
+
+	/// \brief Truncate one data object of a batch, converting exceptions into error codes so that one failure does
+	/// not abort the rest of the batch.
+	///
+	/// \p _template is the input of the whole request. Keywords which describe the batch rather than the individual
+	/// objects are not passed on, and the priority defaults to "bulk".
+	auto truncate_batch_entry(RsComm& _comm,
+	                          const DataObjInp& _template,
+	                          const batch_entry& _entry,
+	                          deferred_notifications* _deferred,
+	                          nlohmann::json& _output) -> int;
+
+	/// \brief Counts the outcomes of the data objects of a batch and keeps the first few failures.
+	class batch_results
+	{
+	  public:
+		/// \brief Record the outcome of truncating \p _logical_path, as returned by truncate_batch_entry.
+		auto add(std::string_view _logical_path, int _ec, const nlohmann::json& _object_output) -> void;
+
+		/// \brief Record a failure which was detected before the data object could be truncated.
+		auto add_failure(std::string_view _logical_path, int _ec, std::string_view _message) -> void;
+
+		/// \brief Write "summary", "failures", and "failures_truncated" into \p _output.
+		auto write(nlohmann::json& _output) const -> void;
+
+		auto matched() const noexcept -> std::uint64_t
+		{
+			return matched_;
+		}
+
+		auto failed() const noexcept -> std::uint64_t
+		{
+			return failed_;
+		}
+
+		/// \brief The error code of the first failure, or zero if there was none.
+		auto first_error() const noexcept -> int
+		{
+			return first_error_;
+		}
+
+	  private:
+		std::uint64_t matched_{};
+		std::uint64_t truncated_{};
+		std::uint64_t skipped_{};
+		std::uint64_t failed_{};
+		int first_error_{};
+		nlohmann::json failures_ = nlohmann::json::array();
+	}; // class batch_results
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_BATCH_HPP
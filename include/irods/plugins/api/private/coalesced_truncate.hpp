@@ -0,0 +1,110 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_COALESCED_TRUNCATE_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_COALESCED_TRUNCATE_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h> // For rodsLong_t.
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace irods::replica_truncate
+{
+	class deadline;
+
+	namespace detail
+	{
+		struct coalescing_slot;
+	} // namespace detail
+
+	/// \brief Coordinates concurrent truncates of the same replica among the agents on this server.
+	///
+	/// The first agent to truncate a replica becomes the leader and does the work. Agents which arrive while the
+	/// leader is working wait for it instead of repeating the pipeline:
+	///  - A request for the same size as the in-flight truncate receives the leader's result.
+	///  - Requests for other sizes are queued. Only the most recent of them is executed once the leader finishes;
+	///    the older ones are superseded and receive the result of the one which was executed.
+	///
+	/// If coordination is not possible (e.g. the shared table is full, its lock is held for too long, or the agent
+	/// which would lead the latest request died or gave up), the caller is told to proceed uncoordinated, which is
+	/// exactly the behavior without this class.
+	class coalesced_truncate
+	{
+	  public:
+		enum class role
+		{
+			leader,
+			follower,
+			uncoordinated
+		};
+
+		/// \brief Join the truncate of replica \p _replica_number of \p _logical_path to \p _size.
+		///
+		/// Blocks while another agent is truncating the same replica on behalf of the same user, but no longer than
+		/// \p _deadline allows.
+		coalesced_truncate(std::string_view _user,
+		                   std::string_view _logical_path,
+		                   int _replica_number,
+		                   rodsLong_t _size,
+		                   const deadline& _deadline);
+
+		coalesced_truncate(const coalesced_truncate&) = delete;
+		auto operator=(const coalesced_truncate&) -> coalesced_truncate& = delete;
+
+		/// \brief Publishes a failure to any followers if the leader did not call complete().
+		~coalesced_truncate();
+
+		auto get_role() const noexcept -> role
+		{
+			return role_;
+		}
+
+		/// \brief The error code of the truncate whose result this follower shares.
+		auto shared_error_code() const noexcept -> int
+		{
+			return shared_ec_;
+		}
+
+		/// \brief Whether the truncate whose result this follower shares modified the replica.
+		auto shared_truncated() const noexcept -> bool
+		{
+			return shared_truncated_;
+		}
+
+		/// \brief The size requested by the truncate whose result this follower shares.
+		///
+		/// This differs from the size requested by the follower when its request was superseded.
+		auto shared_size() const noexcept -> rodsLong_t
+		{
+			return shared_size_;
+		}
+
+		/// \brief The size left by a truncate which completed while this leader was waiting, if any.
+		///
+		/// Information about the replica read before waiting is stale when this is set.
+		auto size_after_wait() const noexcept -> const std::optional<rodsLong_t>&
+		{
+			return size_after_wait_;
+		}
+
+		/// \brief Publish the leader's result to every follower waiting on it.
+		///
+		/// If the shared table cannot be locked, the result is kept and published by the next coalesced_truncate this
+		/// agent creates.
+		auto complete(int _ec, bool _truncated) -> void;
+
+	  private:
+		role role_{role::uncoordinated};
+		detail::coalescing_slot* slot_{};
+		std::uint64_t ticket_{};
+		bool completed_{};
+		int shared_ec_{};
+		bool shared_truncated_{};
+		rodsLong_t shared_size_{};
+		std::optional<rodsLong_t> size_after_wait_;
+	}; // class coalesced_truncate
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_COALESCED_TRUNCATE_HPP
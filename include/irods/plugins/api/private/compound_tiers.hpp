@@ -0,0 +1,62 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_COMPOUND_TIERS_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_COMPOUND_TIERS_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Forward declarations.
+struct DataObjInfo;
+
+namespace irods::replica_truncate
+{
+	/// \brief The children of a compound resource.
+	enum class compound_tier
+	{
+		cache,
+		archive
+	};
+
+	auto to_string(compound_tier _tier) noexcept -> const char*;
+
+	/// \brief Where a hierarchy passes through a compound resource.
+	struct compound_position
+	{
+		// The hierarchy up to and including the compound resource.
+		std::string compound_hierarchy;
+		compound_tier tier;
+	}; // struct compound_position
+
+	/// \brief Whether the "compound" settings allow truncating both tiers of a compound resource in place.
+	///
+	/// A compound resource copies the whole replica from its cache to its archive whenever the cache replica is
+	/// modified. When both tiers can truncate natively, truncating each of them in place is far cheaper. Off unless
+	/// an administrator opts in, since it changes which replica fileModified is fired for.
+	auto truncates_tiers_in_place() -> bool;
+
+	/// \brief Find the compound resource in \p _hierarchy, if there is one, and the tier below it.
+	auto find_compound_position(std::string_view _hierarchy) -> std::optional<compound_position>;
+
+	/// \brief The replica in \p _replicas on the other tier of the compound resource at \p _position, if any.
+	auto find_other_tier(DataObjInfo* _replicas, const compound_position& _position) -> DataObjInfo*;
+
+	/// \brief Whether the archive leaf of \p _hierarchy is of a type which is configured to truncate natively.
+	///
+	/// Archives are often tape systems which cannot truncate, so they are only asked to when the configuration
+	/// says so.
+	auto archive_can_truncate(std::string_view _hierarchy) -> bool;
+
+	/// \brief The replica to truncate when every replica of the data object is in one compound resource and only the
+	/// archive holds one.
+	///
+	/// Resolving the hierarchy by voting would stage the whole replica into the cache before truncating it.
+	/// Truncating the archive replica directly avoids that, as long as the archive can truncate natively.
+	///
+	/// \return nullptr if the data object is not in that situation.
+	auto select_archive_only_replica(const DataObjInfo* _replicas) -> const DataObjInfo*;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_COMPOUND_TIERS_HPP
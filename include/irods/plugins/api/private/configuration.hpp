@@ -0,0 +1,21 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_CONFIGURATION_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_CONFIGURATION_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+namespace irods::replica_truncate
+{
+	/// \brief The plugin's section of server_config.json.
+	///
+	/// The section is found at plugin_configuration.api.irods_api_plugin_replica_truncate. An empty object is returned
+	/// if the section does not exist, so every setting must have a default.
+	///
+	/// The configuration is read once per agent. Agents are started for each connection, so changes take effect for
+	/// new connections without restarting the server.
+	auto plugin_configuration() -> const nlohmann::json&;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_CONFIGURATION_HPP
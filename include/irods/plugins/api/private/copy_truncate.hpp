@@ -0,0 +1,76 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_COPY_TRUNCATE_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_COPY_TRUNCATE_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h>
+
+#include <string_view>
+
+// Forward declarations.
+struct RsComm;
+
+namespace irods::replica_truncate
+{
+	/// \brief Whether \p _ec means that the resource cannot truncate a file itself.
+	auto is_truncate_unsupported(int _ec) noexcept -> bool;
+
+	/// \brief Copy the first \p _length bytes of a replica's data into a new file on the server which hosts it.
+	///
+	/// The data is read and written through the resource plugin by this server. If another server hosts the storage,
+	/// every byte crosses the network to this server and back. If the data is shorter than \p _length, the copy is
+	/// padded with zeros. The new file gets the permission bits of the original, and is removed if anything fails.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _logical_path The logical path of the data object. Passed to the resource plugin.
+	/// \param[in] _physical_path The physical path of the replica's data.
+	/// \param[in] _hierarchy The resource hierarchy of the replica.
+	/// \param[in] _destination_path The physical path of the new file. It must not exist.
+	/// \param[in] _length The number of bytes to copy.
+	///
+	/// \return iRODS error code.
+	auto copy_physical_data(RsComm& _comm,
+	                        std::string_view _logical_path,
+	                        std::string_view _physical_path,
+	                        std::string_view _hierarchy,
+	                        std::string_view _destination_path,
+	                        rodsLong_t _length) -> int;
+
+	/// \brief Remove a file created next to a replica's data, through the resource plugin on the server which hosts it.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _logical_path The logical path of the data object. Passed to the resource plugin.
+	/// \param[in] _hierarchy The resource hierarchy of the replica.
+	/// \param[in] _physical_path The physical path of the file to remove.
+	///
+	/// \return iRODS error code.
+	auto unlink_physical_data(RsComm& _comm,
+	                          std::string_view _logical_path,
+	                          std::string_view _hierarchy,
+	                          std::string_view _physical_path) -> int;
+
+	/// \brief Truncate a replica's data for resources which cannot do it natively.
+	///
+	/// The first \p _length bytes of the data are copied into a new file next to it, which is then renamed over the
+	/// original. The data is copied by this server as described for copy_physical_data, so callers should only use
+	/// it on the server which hosts the storage. It never passes through the client. If the data is shorter than
+	/// \p _length, the copy is padded with zeros just as a native truncate would.
+	///
+	/// The original is left untouched if anything fails before the rename.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _logical_path The logical path of the data object. Passed to the resource plugin.
+	/// \param[in] _physical_path The physical path of the replica's data.
+	/// \param[in] _hierarchy The resource hierarchy of the replica.
+	/// \param[in] _length The size to truncate to.
+	///
+	/// \return iRODS error code.
+	auto copy_truncate(RsComm& _comm,
+	                   std::string_view _logical_path,
+	                   std::string_view _physical_path,
+	                   std::string_view _hierarchy,
+	                   rodsLong_t _length) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_COPY_TRUNCATE_HPP
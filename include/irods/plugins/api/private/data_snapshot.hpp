@@ -0,0 +1,77 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_DATA_SNAPSHOT_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_DATA_SNAPSHOT_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Forward declarations.
+struct RsComm;
+
+namespace irods::replica_truncate
+{
+	/// \brief How a snapshot of a replica's data may be made.
+	enum class snapshot_mode
+	{
+		// Copy-on-write clone only. Fails if the storage cannot clone.
+		clone,
+		// Copy-on-write clone if the storage can clone, and a full copy otherwise.
+		clone_or_copy
+	};
+
+	/// \brief Parse the value of TRUNCATE_SNAPSHOT_KW.
+	auto to_snapshot_mode(std::string_view _mode) -> std::optional<snapshot_mode>;
+
+	/// \brief A copy of a replica's data made before it was truncated.
+	struct data_snapshot
+	{
+		// The data object the snapshot is registered as.
+		std::string logical_path;
+		std::string physical_path;
+		// "clone" or "copy".
+		const char* method{};
+	}; // struct data_snapshot
+
+	/// \brief Preserve a replica's data in a new file next to it before the replica is truncated.
+	///
+	/// A unixfilesystem resource hosted by this server is cloned with FICLONE, which shares the data blocks with the
+	/// original on file systems which support it (e.g. Btrfs, XFS with reflink), so the snapshot costs next to no
+	/// I/O. Otherwise, if \p _mode allows it, the data is copied through the resource plugin on the server which
+	/// hosts it.
+	///
+	/// The snapshot is registered as a new data object next to the original, owned by the client, so that it can be
+	/// found, restored, and removed like any other. The client needs permission to create data objects in the
+	/// original's collection, but not the rodsadmin privileges which registering a file in a vault otherwise takes.
+	/// If it cannot be registered, the file is removed again. The snapshot's file gets the permission bits of the
+	/// original.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _logical_path The logical path of the data object.
+	/// \param[in] _physical_path The physical path of the replica's data.
+	/// \param[in] _hierarchy The resource hierarchy of the replica.
+	/// \param[in] _size The size of the replica's data.
+	/// \param[in] _mode Whether to fall back to a full copy.
+	/// \param[out] _snapshot Where the snapshot was made, and how.
+	///
+	/// \return iRODS error code.
+	/// \retval SYS_NOT_SUPPORTED if \p _mode is snapshot_mode::clone and the storage cannot clone.
+	auto snapshot_physical_data(RsComm& _comm,
+	                            std::string_view _logical_path,
+	                            std::string_view _physical_path,
+	                            std::string_view _hierarchy,
+	                            rodsLong_t _size,
+	                            snapshot_mode _mode,
+	                            data_snapshot& _snapshot) -> int;
+
+	/// \brief Unregister \p _snapshot and remove its data, e.g. because the truncate it was made for failed.
+	///
+	/// \return iRODS error code.
+	auto remove_snapshot(RsComm& _comm, const data_snapshot& _snapshot) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_DATA_SNAPSHOT_HPP
@@ -0,0 +1,50 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_DEADLINE_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_DEADLINE_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <optional>
+
+// Forward declarations.
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	/// \brief The point in time after which the client is no longer waiting for a result.
+	///
+	/// The deadline is carried in TRUNCATE_DEADLINE_KW as milliseconds since the Unix epoch so that it means the same
+	/// thing on every server the request is forwarded to, give or take clock skew.
+	class deadline
+	{
+	  public:
+		using clock_type = std::chrono::system_clock;
+
+		/// \brief The error code returned for requests whose deadline has passed. No other failure returns it.
+		static constexpr int error_code = REPLICA_TRUNCATE_DEADLINE_EXCEEDED;
+
+		/// \brief Read the deadline from \p _input. A request without one never expires.
+		///
+		/// \throws irods::exception If the keyword's value is not an integer.
+		static auto from_input(const DataObjInp& _input) -> deadline;
+
+		/// \brief Whether the deadline has passed.
+		auto expired() const -> bool;
+
+		/// \brief \p _timeout, shortened if the deadline comes sooner.
+		auto cap(std::chrono::milliseconds _timeout) const -> std::chrono::milliseconds;
+
+		/// \brief Fill in \p _output for a request abandoned in \p _phase, and return error_code.
+		auto fail(nlohmann::json& _output, const char* _logical_path, const char* _phase) const -> int;
+
+	  private:
+		std::optional<clock_type::time_point> at_;
+	}; // class deadline
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_DEADLINE_HPP
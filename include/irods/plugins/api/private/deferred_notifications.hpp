@@ -0,0 +1,61 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_DEFERRED_NOTIFICATIONS_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_DEFERRED_NOTIFICATIONS_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/objInfo.h>
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Forward declarations.
+struct RsComm;
+
+namespace irods::replica_truncate
+{
+	/// \brief Fire fileModified for \p _replica as rsModDataObjMeta does when OPEN_TYPE_KW is present.
+	///
+	/// \return iRODS error code.
+	auto notify_modified(RsComm& _comm, DataObjInfo& _replica) -> int;
+
+	/// \brief fileModified notifications held back until a batch of truncates is finished.
+	///
+	/// Normally, updating the catalog after a truncate fires fileModified, and with it the full policy chain, for
+	/// each replica. A batch collects the replicas instead and fires fileModified once for each distinct replica when
+	/// it is delivered.
+	///
+	/// A batch only ever holds replicas truncated by this agent. Truncates handed off to another server notify as
+	/// usual.
+	class deferred_notifications
+	{
+	  public:
+		/// \brief Remember that \p _replica was modified. Replicas which were already added are ignored.
+		///
+		/// Only the fields fileModified needs are kept, so \p _replica may be freed afterwards.
+		auto add(const DataObjInfo& _replica) -> void;
+
+		/// \brief Fire fileModified for every replica added since the last delivery.
+		///
+		/// Failures do not stop the remaining notifications.
+		///
+		/// \return The first error encountered, or 0.
+		auto deliver(RsComm& _comm) -> int;
+
+		/// \brief Counts of replicas added, delivered, and failed so far.
+		auto summary() const -> nlohmann::json;
+
+	  private:
+		std::vector<DataObjInfo> pending_;
+		std::set<std::pair<std::string, std::string>> seen_;
+		std::size_t delivered_{};
+		std::size_t failed_{};
+	}; // class deferred_notifications
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_DEFERRED_NOTIFICATIONS_HPP
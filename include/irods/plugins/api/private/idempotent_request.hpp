@@ -0,0 +1,79 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_IDEMPOTENT_REQUEST_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_IDEMPOTENT_REQUEST_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Forward declarations.
+struct RsComm;
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	class deadline;
+
+	/// \brief Remembers the results of requests carrying TRUNCATE_REQUEST_ID_KW, so that a retry returns the result of
+	/// the original request instead of running again.
+	///
+	/// Results are kept in a table shared by every agent on this server for the configured "ttl_in_seconds".
+	/// Successful results are kept, and so are failures which happened after the data was truncated (e.g. while
+	/// updating the catalog or notifying resources), which are marked by "data_truncated" in the output. Any other
+	/// failure left the replica alone, so running the request again is what the client wants. A collection or manifest
+	/// which failed runs again too. Data objects which it already truncated are skipped if the catalog has their new
+	/// size, and truncated again to the same size otherwise.
+	///
+	/// If the table cannot be used (e.g. it is full of requests which are still running or an agent died while
+	/// holding its lock), the request runs unrecorded, which is exactly the behavior without a request ID.
+	class idempotent_request
+	{
+	  public:
+		/// \brief Claim the request ID of \p _input, if it has one.
+		///
+		/// Blocks while another agent is running a request with the same ID on behalf of the same user, but no longer
+		/// than \p _deadline allows.
+		///
+		/// \throws irods::exception If the request ID is invalid, or was used earlier with different input.
+		idempotent_request(const RsComm& _comm, const DataObjInp& _input, const deadline& _deadline);
+
+		idempotent_request(const idempotent_request&) = delete;
+		auto operator=(const idempotent_request&) -> idempotent_request& = delete;
+
+		/// \brief Releases the claim if record() was not called, so that a retry runs again.
+		~idempotent_request();
+
+		/// \brief If the request must not run, fill in \p _output with what to return instead and return its error
+		/// code.
+		///
+		/// This is the stored result of the original request, with "replayed" set, or a failure if the original
+		/// request was still running when the wait for it ended.
+		auto replay(nlohmann::json& _output) const -> std::optional<int>;
+
+		/// \brief Remember the result of the request for retries, unless it failed before the data was truncated.
+		auto record(int _ec, const nlohmann::json& _output) -> void;
+
+	  private:
+		enum class state
+		{
+			unrecorded,
+			claimed,
+			replay
+		};
+
+		auto release() -> void;
+
+		state state_{state::unrecorded};
+		std::size_t slot_index_{};
+		std::uint64_t generation_{};
+		std::int64_t ttl_seconds_{};
+		int replay_ec_{};
+		nlohmann::json replay_output_;
+	}; // class idempotent_request
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_IDEMPOTENT_REQUEST_HPP
@@ -0,0 +1,85 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_LOGGING_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_LOGGING_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <fmt/format.h>
+
+#include <string>
+#include <utility>
+
+/// \brief Logging for the server-side plugin.
+///
+/// Every message belongs to a category whose verbosity, sampling, and rate limit are set in the "logging" section of
+/// the plugin configuration. Messages which are not wanted are discarded before they are formatted. The rest are
+/// handed to a background thread which writes them to the server log, so that a truncate never waits on the log.
+namespace irods::replica_truncate::logging
+{
+	enum class category
+	{
+		request,
+		selection,
+		redirect,
+		coalescing,
+		admission,
+		collection,
+		deadline,
+		usage,
+		idempotency
+	};
+
+	enum class level
+	{
+		trace,
+		debug,
+		info,
+		warn,
+		error
+	};
+
+	/// \brief Decide whether a message should be written, and count it against the sampling and rate limits.
+	///
+	/// Messages below warn are sampled. Messages of every level are rate-limited. The number of messages which were
+	/// rate-limited is reported with the next message of the category which is written.
+	auto should_write(category _category, level _level) -> bool;
+
+	/// \brief Queue \p _message for the background thread.
+	///
+	/// If the queue is full, the message is dropped and counted. Only call this after should_write returned true.
+	auto submit(category _category, level _level, std::string _message) -> void;
+
+	template <typename... Args>
+	auto write(category _category, level _level, fmt::format_string<Args...> _format, Args&&... _args) -> void
+	{
+		if (should_write(_category, _level)) {
+			submit(_category, _level, fmt::format(_format, std::forward<Args>(_args)...));
+		}
+	} // write
+
+	template <typename... Args>
+	auto debug(category _category, fmt::format_string<Args...> _format, Args&&... _args) -> void
+	{
+		write(_category, level::debug, _format, std::forward<Args>(_args)...);
+	} // debug
+
+	template <typename... Args>
+	auto info(category _category, fmt::format_string<Args...> _format, Args&&... _args) -> void
+	{
+		write(_category, level::info, _format, std::forward<Args>(_args)...);
+	} // info
+
+	template <typename... Args>
+	auto warn(category _category, fmt::format_string<Args...> _format, Args&&... _args) -> void
+	{
+		write(_category, level::warn, _format, std::forward<Args>(_args)...);
+	} // warn
+
+	template <typename... Args>
+	auto error(category _category, fmt::format_string<Args...> _format, Args&&... _args) -> void
+	{
+		write(_category, level::error, _format, std::forward<Args>(_args)...);
+	} // error
+} // namespace irods::replica_truncate::logging
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_LOGGING_HPP
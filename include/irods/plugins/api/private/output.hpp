@@ -0,0 +1,23 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_OUTPUT_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_OUTPUT_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+// Forward declarations.
+struct BytesBuf;
+
+namespace irods::replica_truncate
+{
+	/// \brief Serialize \p _output into a heap-allocated BytesBuf which the API framework will free.
+	///
+	/// A "message" member is always present in the result so that clients can rely on it. The JSON is serialized into
+	/// a static buffer which the agent reuses for every request, so the text only reaches the heap in the BytesBuf.
+	/// Output larger than the buffer spills over into the heap. nlohmann::json still allocates its output adapter and
+	/// indentation buffer from the heap. Nothing else about the request is allocated from the buffer.
+	auto make_output_struct(nlohmann::json _output) -> BytesBuf*;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_OUTPUT_HPP
@@ -0,0 +1,45 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_RECORD_BOUNDARY_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_RECORD_BOUNDARY_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h>
+
+#include <string_view>
+
+// Forward declarations.
+struct RsComm;
+
+namespace irods::replica_truncate
+{
+	/// \brief Find the end of the last complete record of a replica's data which ends at or below \p _max_size.
+	///
+	/// The data is read backward from min(\p _max_size, \p _data_size) in chunks through the resource plugin on the
+	/// server which hosts the storage, and each chunk is searched for \p _delimiter with memrchr. Only the bytes
+	/// between the boundary and the starting offset are read. The search gives up after the "max_scan_in_bytes" of
+	/// the "record_boundary" settings.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _logical_path The logical path of the data object. Passed to the resource plugin.
+	/// \param[in] _physical_path The physical path of the replica's data.
+	/// \param[in] _hierarchy The resource hierarchy of the replica.
+	/// \param[in] _delimiter The byte which ends each record.
+	/// \param[in] _max_size The size which the data must not exceed once truncated.
+	/// \param[in] _data_size The current size of the data.
+	/// \param[out] _boundary The size which keeps every complete record, including its delimiter. 0 if the data has no
+	/// complete record.
+	///
+	/// \return iRODS error code.
+	/// \retval SYS_INVALID_INPUT_PARAM if no delimiter was found within the scan limit.
+	auto find_record_boundary(RsComm& _comm,
+	                          std::string_view _logical_path,
+	                          std::string_view _physical_path,
+	                          std::string_view _hierarchy,
+	                          char _delimiter,
+	                          rodsLong_t _max_size,
+	                          rodsLong_t _data_size,
+	                          rodsLong_t& _boundary) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_RECORD_BOUNDARY_HPP
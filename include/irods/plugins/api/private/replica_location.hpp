@@ -0,0 +1,39 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_REPLICA_LOCATION_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_REPLICA_LOCATION_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <string_view>
+
+// Forward declarations.
+struct DataObjInfo;
+struct rodsServerHost;
+
+namespace irods::replica_truncate
+{
+	/// \brief The server which hosts the storage of \p _hierarchy.
+	///
+	/// \return A pointer into the server's host table, or nullptr if the host could not be resolved.
+	auto host_for_hierarchy(std::string_view _hierarchy) -> rodsServerHost*;
+
+	/// \brief Whether the storage of \p _hierarchy is hosted by this server.
+	auto is_local_hierarchy(std::string_view _hierarchy) -> bool;
+
+	/// \brief Choose a replica from \p _replicas whose storage is hosted by this server.
+	///
+	/// Replicas are ranked by the following criteria, in order:
+	///  1. At rest before not at rest (the latter cannot be truncated).
+	///  2. Good before stale.
+	///  3. Lower replica number first.
+	///
+	/// Replicas in the bundle resource, hosted by another server, or below a resource which is down are never chosen.
+	///
+	/// \param[in] _replicas The head of a list of replicas of one data object.
+	///
+	/// \return The chosen replica, or nullptr if no replica is eligible. The caller should then resolve the hierarchy
+	/// by voting.
+	auto select_local_replica(const DataObjInfo* _replicas) -> const DataObjInfo*;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_REPLICA_LOCATION_HPP
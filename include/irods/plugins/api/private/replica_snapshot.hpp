@@ -0,0 +1,69 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_REPLICA_SNAPSHOT_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_REPLICA_SNAPSHOT_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h> // For rodsLong_t.
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations.
+struct RsComm;
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	struct batch_entry;
+
+	/// \brief The catalog's information about the replicas of many data objects, fetched with a few queries.
+	///
+	/// Truncating a data object starts by reading its replicas from the catalog, one query per data object. For a
+	/// batch of data objects, the snapshot fetches the replicas of all of them with one query per collection, so that
+	/// data objects which need no work can be answered without touching the catalog again.
+	///
+	/// The snapshot is only used to decide that nothing needs to be done. Data objects which need work still go
+	/// through the whole truncate, which reads the catalog again, so a stale snapshot never causes a wrong truncate.
+	/// Only data objects which the client may modify are fetched, so the others go through the whole truncate as
+	/// well, along with its access checks.
+	class replica_snapshot
+	{
+	  public:
+		struct replica
+		{
+			int replica_number;
+			rodsLong_t size;
+			int status;
+			std::string hierarchy;
+		}; // struct replica
+
+		/// \brief Fetch the replicas of those of \p _logical_paths which the client of \p _comm may modify.
+		///
+		/// Paths which cannot be queried safely, or whose query fails, are left out of the snapshot. The failure is
+		/// logged and the data objects are truncated the usual way.
+		auto fetch(RsComm& _comm, const std::vector<std::string_view>& _logical_paths) -> void;
+
+		/// \brief Whether truncating \p _entry would find its target replica at rest and already of the requested
+		/// size, no matter which of its candidate replicas is chosen.
+		///
+		/// \param[in] _entry The data object and its replica selection.
+		/// \param[in] _template The input of the whole request, for its replica selection keywords.
+		///
+		/// \return false if the data object is not in the snapshot, or if \p _template is input which truncate_replica
+		/// rejects.
+		auto already_truncated(const batch_entry& _entry, const DataObjInp& _template) const -> bool;
+
+		auto clear() -> void
+		{
+			replicas_.clear();
+		}
+
+	  private:
+		std::unordered_map<std::string, std::vector<replica>> replicas_;
+	}; // class replica_snapshot
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_REPLICA_SNAPSHOT_HPP
@@ -0,0 +1,82 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_SHARED_MEMORY_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_SHARED_MEMORY_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/sync/interprocess_condition_any.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+
+#include <pthread.h>
+#include <sys/types.h>
+
+#include <chrono>
+
+namespace irods::replica_truncate::shared_memory
+{
+	/// \brief A mutex for the shared memory segment which is released when the process holding it dies.
+	///
+	/// A process-shared mutex which is not robust stays locked forever once its owner is killed, which would block
+	/// every agent on the server until the segment is removed by hand. The next agent to lock this one after its owner
+	/// died acquires it and carries on with the data as the dead agent left it. Every table in the segment already
+	/// tolerates entries left behind by dead agents.
+	class robust_mutex
+	{
+	  public:
+		/// \throws boost::interprocess::interprocess_exception If the mutex cannot be initialized.
+		robust_mutex();
+
+		robust_mutex(const robust_mutex&) = delete;
+		auto operator=(const robust_mutex&) -> robust_mutex& = delete;
+
+		~robust_mutex();
+
+		/// \throws boost::interprocess::lock_exception If the mutex cannot be locked.
+		auto lock() -> void;
+
+		auto try_lock() -> bool;
+
+		/// \brief Lock the mutex, giving up at \p _time.
+		auto try_lock_until(std::chrono::system_clock::time_point _time) -> bool;
+
+		auto unlock() -> void;
+
+	  private:
+		pthread_mutex_t mutex_{};
+	}; // class robust_mutex
+
+	using mutex_type = robust_mutex;
+	using lock_type = boost::interprocess::scoped_lock<mutex_type>;
+
+	// The condition variables of Boost.Interprocess only work with its own mutex, which is not robust.
+	using condition_type = boost::interprocess::interprocess_condition_any;
+
+	/// \brief The shared memory segment used by every agent on this server to coordinate with one another.
+	///
+	/// The segment is created by the first agent which needs it and outlives the agents. Objects placed in it must
+	/// therefore tolerate being left behind by an agent which exited (or crashed) while using them.
+	///
+	/// \throws boost::interprocess::interprocess_exception If the segment cannot be created or opened.
+	auto segment() -> boost::interprocess::managed_shared_memory&;
+
+	/// \brief Find the object named \p _name in the segment, default-constructing it if it does not exist yet.
+	///
+	/// \throws boost::interprocess::interprocess_exception If the segment cannot be created or opened.
+	template <typename T>
+	auto find_or_construct(const char* _name) -> T&
+	{
+		return *segment().find_or_construct<T>(_name)();
+	} // find_or_construct
+
+	/// \brief Lock \p _mutex, giving up after \p _timeout.
+	///
+	/// A lock left behind by an agent which died is recovered, but a live agent may still hold one for a long time, so
+	/// callers must never block indefinitely. The returned lock does not own the mutex if the timeout expired.
+	auto lock_for(mutex_type& _mutex, std::chrono::milliseconds _timeout) -> lock_type;
+
+	/// \brief Whether the process \p _pid still exists.
+	auto process_exists(pid_t _pid) noexcept -> bool;
+} // namespace irods::replica_truncate::shared_memory
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_SHARED_MEMORY_HPP
@@ -0,0 +1,39 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_COLLECTION_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_COLLECTION_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+// Forward declarations.
+struct RsComm;
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	/// \brief Truncate every data object under the collection named by \p _input.objPath.
+	///
+	/// The catalog is iterated one page at a time, so memory use does not depend on the size of the collection. Each
+	/// matching data object is truncated with truncate_replica using a copy of \p _input's condInput, so replica
+	/// selection keywords apply to every object.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _input \parblock The same input accepted by rs_replica_truncate with TRUNCATE_COLLECTION_KW set.
+	/// TRUNCATE_NAME_LIKE_KW, TRUNCATE_ONLY_IF_LARGER_KW, and TRUNCATE_PAGE_SIZE_KW are honored.
+	/// \endparblock
+	/// \param[in,out] _output \parblock JSON object into which results are written. On return, the following members
+	/// will be set:
+	///		"message" - A descriptive error or informational message.
+	///		"summary" - Object with counts of "matched", "truncated", "skipped", and "failed" data objects.
+	///		"failures" - Array of objects with "path", "error_code", and "message" for each failed data object. Only
+	///		 the first failures are listed; "failures_truncated" is true if some were left out.
+	/// \endparblock
+	///
+	/// \return iRODS error code.
+	/// \retval 0 if every matching data object was truncated or skipped
+	/// \retval <0 the error code of the first failure, or of the catalog query
+	auto truncate_collection(RsComm& _comm, DataObjInp& _input, nlohmann::json& _output) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_COLLECTION_HPP
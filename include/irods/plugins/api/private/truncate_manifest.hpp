@@ -0,0 +1,40 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_MANIFEST_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_MANIFEST_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+// Forward declarations.
+struct RsComm;
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	/// \brief Truncate every data object listed in the manifest named by \p _input.objPath.
+	///
+	/// The manifest is a data object holding one JSON object per line:
+	/// \code{.js}
+	/// {"path": "<string>", "size": <integer>, "replica_number": <integer>, "resource": "<string>"}
+	/// \endcode
+	/// Only "path" is required. "size" defaults to \p _input.dataSize. "replica_number" and "resource" override the
+	/// replica selection of \p _input for that entry, and may not be used together.
+	///
+	/// The manifest is read a chunk at a time and its entries are processed in windows of a few hundred, so memory use
+	/// does not depend on the number of entries. The replicas of each window are fetched from the catalog with one
+	/// query per collection, and entries whose target replica already has the requested size are skipped without
+	/// further catalog access. The remaining entries are truncated with truncate_replica.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _input The same input accepted by rs_replica_truncate with TRUNCATE_MANIFEST_KW set.
+	/// \param[in,out] _output The same members as set by truncate_collection. Lines which cannot be used are
+	/// reported as failures.
+	///
+	/// \return iRODS error code.
+	/// \retval 0 if every entry was truncated or skipped
+	/// \retval <0 the error code of the first failure, or of reading the manifest
+	auto truncate_manifest(RsComm& _comm, DataObjInp& _input, nlohmann::json& _output) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_MANIFEST_HPP
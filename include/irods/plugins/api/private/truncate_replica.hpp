@@ -0,0 +1,44 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_REPLICA_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_REPLICA_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <nlohmann/json.hpp>
+
+// Forward declarations.
+struct RsComm;
+struct DataObjInp;
+
+namespace irods::replica_truncate
+{
+	class deferred_notifications;
+
+	/// \brief Truncate one replica of the data object described by \p _input.
+	///
+	/// This is the per-object part of the API: it resolves the target replica, validates that it can be truncated,
+	/// truncates the data, and updates the catalog. Remote zone redirection and authorization of the admin keyword
+	/// are the responsibility of the caller.
+	///
+	/// \param[in] _comm iRODS server connection object.
+	/// \param[in] _input The same input accepted by rs_replica_truncate.
+	/// \param[in,out] _output \parblock JSON object into which results are written. On return, the following members
+	/// will be set:
+	///		"message" - A descriptive error or informational message. Empty when the replica was truncated.
+	///		"truncated" - Whether the replica was modified.
+	///		"replica_number" and "resource_hierarchy" - The replica chosen, once one has been.
+	/// \endparblock
+	/// \param[in,out] _deferred If not null, fileModified is not fired for the replica. Instead, the replica is added
+	/// to \p _deferred, and the caller is responsible for delivering the notification. Ignored when the truncate is
+	/// handed off to another server.
+	///
+	/// \return iRODS error code.
+	/// \retval 0 on success (including when there was nothing to do)
+	/// \retval <0 on failure
+	auto truncate_replica(RsComm& _comm,
+	                      DataObjInp& _input,
+	                      nlohmann::json& _output,
+	                      deferred_notifications* _deferred = nullptr) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_TRUNCATE_REPLICA_HPP
@@ -0,0 +1,43 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_USAGE_LEDGER_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_USAGE_LEDGER_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <irods/rodsType.h>
+
+#include <nlohmann/json.hpp>
+
+#include <string_view>
+
+namespace irods::replica_truncate
+{
+	/// \brief Record the change in size of one replica in the usage ledger of this server.
+	///
+	/// The ledger accumulates signed byte deltas per resource and per owner, shared by every agent on this server.
+	/// Failures to record are logged but never fail the truncate.
+	///
+	/// \param[in] _hierarchy The resource hierarchy of the replica. The change is recorded against its leaf, which is
+	/// the resource whose storage changed and whose name is the same no matter which resource reported the replica.
+	/// \param[in] _owner The owner of the data object, as "user#zone".
+	/// \param[in] _old_size The size of the replica before the truncate.
+	/// \param[in] _new_size The size of the replica after the truncate.
+	auto record_usage_change(std::string_view _hierarchy,
+	                         std::string_view _owner,
+	                         rodsLong_t _old_size,
+	                         rodsLong_t _new_size) noexcept -> void;
+
+	/// \brief The contents of the usage ledger of this server.
+	///
+	/// \param[in] _reset \parblock If true, the ledger is emptied in the same step, so that no change is lost between
+	/// reading the ledger and clearing it. Do this right after a full quota recalculation, so that the ledger only
+	/// holds the changes which the recalculation has not seen.
+	/// \endparblock
+	///
+	/// \return A JSON object with "since" (seconds since the Unix epoch at which the ledger was last reset),
+	/// "overflowed" (the number of changes which could not be recorded because the ledger was full), and "resources",
+	/// which maps resource names to objects mapping owners to their "bytes" and "truncates".
+	auto usage_ledger(bool _reset) -> nlohmann::json;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_USAGE_LEDGER_HPP
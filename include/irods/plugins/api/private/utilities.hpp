@@ -0,0 +1,49 @@
+#ifndef IRODS_REPLICA_TRUNCATE_PRIVATE_UTILITIES_HPP
+#define IRODS_REPLICA_TRUNCATE_PRIVATE_UTILITIES_HPP
+
+// This file is for the implementation of the plugin. Symbols declared and/or defined in
+// this header MUST NOT be used outside of the plugin.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace irods::replica_truncate
+{
+	/// \brief Copy \p _src into one of the fixed-size string fields of the iRODS API structures.
+	///
+	/// \p _src is cut short if it does not fit. \p _dst is always null-terminated.
+	template <std::size_t N>
+	auto copy_into(char (&_dst)[N], std::string_view _src) noexcept -> void
+	{
+		const auto n = std::min(_src.size(), N - 1);
+		std::memcpy(_dst, _src.data(), n);
+		_dst[n] = '\0';
+	} // copy_into
+
+	/// \brief The resource at the root of \p _hierarchy.
+	auto root_of(std::string_view _hierarchy) noexcept -> std::string_view;
+
+	/// \brief The resource at the leaf of \p _hierarchy, i.e. the one which stores the data.
+	auto leaf_of(std::string_view _hierarchy) noexcept -> std::string_view;
+
+	/// \brief Whether a replica with the status \p _replica_status is good or stale, i.e. not being written to.
+	auto is_at_rest(int _replica_status) noexcept -> bool;
+
+	/// \brief \p _value as a quoted literal for a GenQuery condition.
+	///
+	/// GenQuery has no way to escape a quote inside of a literal, so values which contain one cannot be used.
+	///
+	/// \return std::nullopt if \p _value cannot be represented.
+	auto genquery_literal(std::string_view _value) -> std::optional<std::string>;
+
+	/// \brief Find the host of the storage of \p _hierarchy, as needed by the addr of the rsFile* inputs.
+	///
+	/// \return iRODS error code.
+	auto host_of_hierarchy(std::string_view _hierarchy, std::string& _host) -> int;
+} // namespace irods::replica_truncate
+
+#endif // IRODS_REPLICA_TRUNCATE_PRIVATE_UTILITIES_HPP
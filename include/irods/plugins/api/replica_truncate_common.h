@@ -3,4 +3,58 @@
 
 static const int APN_REPLICA_TRUNCATE = 1'000'444;
 
+// Returned when a request stops because TRUNCATE_DEADLINE_KW has passed. It is derived from the API number so that it
+// cannot be confused with any code in rodsErrorTable.h, such as a socket timeout. rodsErrorName() does not know it.
+static const int REPLICA_TRUNCATE_DEADLINE_EXCEEDED = -APN_REPLICA_TRUNCATE * 1000;
+
+// Keywords recognized in DataObjInp::condInput, in addition to the standard iRODS keywords.
+
+// If present, objPath names a collection and every data object under it (recursively) is truncated to dataSize.
+#define TRUNCATE_COLLECTION_KW          "truncate_collection"
+// If present, objPath names a data object holding one JSON object per line, each naming a data object to truncate
+// with "path" and optionally "size", "replica_number", or "resource". dataSize is the default size, or -1 for none.
+#define TRUNCATE_MANIFEST_KW            "truncate_manifest"
+// Collection mode only. Only data objects whose names match this GenQuery LIKE pattern are truncated.
+#define TRUNCATE_NAME_LIKE_KW           "truncate_name_like"
+// Collection mode only. If present, only data objects larger than dataSize are truncated.
+#define TRUNCATE_ONLY_IF_LARGER_KW      "truncate_only_if_larger"
+// Collection mode only. Number of rows fetched from the catalog per page. Clamped to [1,MAX_SQL_ROWS].
+#define TRUNCATE_PAGE_SIZE_KW           "truncate_page_size"
+// Collection and manifest modes only. If present, fileModified is fired once per distinct replica after every data
+// object has been truncated instead of after each data object.
+#define TRUNCATE_DEFER_NOTIFICATIONS_KW "truncate_defer_notifications"
+// "interactive" (default) or "bulk". Bulk requests yield to interactive ones under admission control. Collection
+// and manifest modes default to "bulk".
+#define TRUNCATE_PRIORITY_KW            "truncate_priority"
+// Milliseconds to wait for the target replica to come to rest instead of failing with LOCKED_DATA_OBJECT_ACCESS.
+// Capped by the server's "max_wait_for_at_rest_in_seconds" setting.
+#define TRUNCATE_WAIT_FOR_AT_REST_KW    "truncate_wait_for_at_rest"
+// "vote" (default) or "local". With "local", and no other replica selection keyword, the server prefers a replica
+// whose storage it hosts rather than resolving the hierarchy by voting.
+#define TRUNCATE_REPLICA_SELECTION_KW   "truncate_replica_selection"
+// Milliseconds since the Unix epoch after which the client is no longer waiting for a result. The server checks it
+// between phases and stops with REPLICA_TRUNCATE_DEADLINE_EXCEEDED once it has passed.
+#define TRUNCATE_DEADLINE_KW            "truncate_deadline"
+// If present, and the resource cannot truncate natively, the server hosting the replica copies the data which is kept
+// into a new file next to it and replaces the original with it. This can be slow for large replicas. Other servers
+// do not make the copy.
+#define TRUNCATE_ALLOW_COPY_KW          "truncate_allow_copy"
+// A single byte which ends each record of the data. If present, dataSize is the maximum size, and the replica is
+// truncated after the last delimiter at or below it, as found on the storage host. The size chosen is returned.
+#define TRUNCATE_TO_DELIMITER_KW        "truncate_to_delimiter"
+// "clone" or "clone_or_copy". If present, the replica's data is preserved in a new file next to it before it is
+// truncated, by a copy-on-write clone or, with "clone_or_copy", a full copy where cloning is not possible.
+#define TRUNCATE_SNAPSHOT_KW            "truncate_snapshot"
+// Up to 64 characters chosen by the client to identify the request. A retry carrying the same ID within the server's
+// "ttl_in_seconds" receives the result of the original request instead of running again.
+#define TRUNCATE_REQUEST_ID_KW          "truncate_request_id"
+// Set by the server when it hands a request off to the server which hosts the target replica. Such requests are not
+// redirected again.
+#define TRUNCATE_REDIRECTED_KW          "truncate_redirected"
+// If present, nothing is truncated. Instead, the server's counters are returned. Requires rodsadmin.
+#define TRUNCATE_STATS_KW               "truncate_stats"
+// With TRUNCATE_STATS_KW, empty the usage ledger in the same step as it is returned. Use it right after a full quota
+// recalculation.
+#define TRUNCATE_RESET_LEDGER_KW        "truncate_reset_ledger"
+
 #endif // IRODS_REPLICA_TRUNCATE_COMMON_H
@@ -33,15 +33,136 @@ struct BytesBuf;
 ///			- "irodsAdmin" - If present, indicates that the user wishes to truncate the replica
 ///			 even if the user does not have permissions on the object. This input is optional. The
 ///			 default value is false. An error will occur if used by unprivileged uesrs.
+///			- "truncate_collection" - If present, objPath names a collection and every data object
+///			 under it (recursively) is truncated to dataSize. The catalog is read one page at a time.
+///			 The "rescName" and "replNum" options apply to each data object. This input is optional.
+///			- "truncate_manifest" - If present, objPath names a data object listing the data objects
+///			 to truncate, one JSON object per line: {"path": "<string>", "size": <integer>,
+///			 "replica_number": <integer>, "resource": "<string>"}. Only "path" is required. "size"
+///			 defaults to dataSize, which may be -1 if every entry has a size. "replica_number" or
+///			 "resource" replace the replica selection keywords for that entry. The manifest is read
+///			 with the client's permissions, a chunk at a time, and processed a few hundred entries at
+///			 a time. Entries whose candidate replicas are all at rest and already of the requested
+///			 size are skipped based on one catalog query per collection. Entries must be in the zone
+///			 of the manifest. This input is optional.
+///			- "truncate_name_like" - With "truncate_collection", only truncate data objects whose
+///			 names match this GenQuery LIKE pattern. This input is optional.
+///			- "truncate_only_if_larger" - With "truncate_collection", only truncate data objects
+///			 which are larger than dataSize. This input is optional.
+///			- "truncate_page_size" - With "truncate_collection", the number of catalog rows fetched
+///			 per page. Must be in the range [1,256]. This input is optional.
+///			- "truncate_defer_notifications" - With "truncate_collection" or "truncate_manifest",
+///			 fire fileModified once per distinct replica after every data object has been processed,
+///			 instead of once per data object as it is truncated. Objects truncated by another server (see
+///			 "redirect_to_owning_server") still notify as they are truncated. This input is optional.
+///			- "truncate_priority" - "interactive" or "bulk". Selects the lane used by admission
+///			 control. Bulk requests always yield to interactive ones. The default is "interactive",
+///			 or "bulk" when "truncate_collection" or "truncate_manifest" is used. This input is optional.
+///			- "truncate_wait_for_at_rest" - The number of milliseconds to wait for the target replica
+///			 to come to rest before failing with LOCKED_DATA_OBJECT_ACCESS. While waiting, the server
+///			 polls only the replica's status. The server caps the wait at its configured
+///			 "max_wait_for_at_rest_in_seconds" (default 60). This input is optional.
+///			- "truncate_replica_selection" - "vote" or "local". With "local", the target replica is
+///			 chosen from the replicas stored on the server handling the request, skipping any below a
+///			 resource which is down, by ranking them as follows: at rest first, then good before
+///			 stale, then lowest replica number. If no replica is eligible, the hierarchy is resolved
+///			 by vote. Has no effect if "rescName", "replNum", or "rescHier" is used. The default is
+///			 "vote", which resolves the hierarchy with a write operation vote. This input is optional.
+///			- "truncate_deadline" - Milliseconds since the Unix epoch after which the client no longer
+///			 needs a result. The server checks the deadline between phases, caps its internal waits
+///			 by it, and forwards it to other servers. Once it has passed, the request stops with
+///			 REPLICA_TRUNCATE_DEADLINE_EXCEEDED and "deadline_exceeded" is set in the output. This
+///			 code is defined in replica_truncate_common.h and is not returned for any other reason,
+///			 so it is never a socket timeout. The catalog is always updated once the data has been
+///			 truncated. This input is optional.
+///			- "truncate_allow_copy" - If present, and the resource cannot truncate natively, the
+///			 server hosting the replica copies its first dataSize bytes into a new file next to it,
+///			 then replaces the replica's data with that file. The data never passes through the
+///			 client. Only the server hosting the replica makes the copy. If the request was not
+///			 redirected to it (see "redirect_to_owning_server"), the truncate fails with the
+///			 resource's original error instead. This input is optional.
+///			- "truncate_to_delimiter" - A single byte which ends each record of the data. If present,
+///			 dataSize is the maximum size, and the replica is truncated just after the last delimiter
+///			 at or below it. The server which hosts the storage searches backward from dataSize, up
+///			 to its configured "max_scan_in_bytes" (default 64 MiB), and fails with
+///			 SYS_INVALID_INPUT_PARAM if no delimiter is found in that range. If the data has no
+///			 delimiter at all, the replica is truncated to 0. This input is optional.
+///			- "truncate_snapshot" - "clone" or "clone_or_copy". If present, the replica's data is
+///			 preserved in a new file next to it before it is truncated. A unixfilesystem resource
+///			 hosted by the server performing the truncate is cloned with FICLONE, which shares the
+///			 data blocks on file systems which support it. Otherwise, "clone" fails with
+///			 SYS_NOT_SUPPORTED and "clone_or_copy" copies the data on the storage host. The file is
+///			 registered, owned by the client, as the data object "<objPath>.snapshot.<ms>" in the
+///			 same resource hierarchy. Nothing is truncated if the snapshot cannot be made or
+///			 registered, and the snapshot is removed again if the truncate fails. This input is
+///			 optional.
+///			- "truncate_request_id" - Up to 64 characters identifying the request. If a request with
+///			 the same ID, input, and user succeeded on this server within the configured
+///			 "ttl_in_seconds" (default 900), its stored result is returned with "replayed" set
+///			 instead of running again. A retry which arrives while the original request is still
+///			 running waits for it. Failed requests are only remembered if they failed after the
+///			 data was truncated ("data_truncated" is set). Reusing an ID for different input fails
+///			 with SYS_INVALID_INPUT_PARAM. This input is optional.
+///			- "truncate_stats" - If present, nothing is truncated and the server's counters are
+///			 returned in the output instead. Requires rodsadmin. This input is optional.
+///			- "truncate_reset_ledger" - With "truncate_stats", empty the usage ledger in the same
+///			 step as it is returned. This input is optional.
 /// \endparblock
 /// \param[out] _output \parblock JSON structure describing outputs from the operation. Should take the following form:
 /// 	\code{.js}
 /// 	{
-/// 	    "message": "<string>"
+/// 	    "message": "<string>",
+/// 	    "truncated": <boolean>,
+/// 	    "replica_number": <integer>,
+/// 	    "resource_hierarchy": "<string>"
 /// 	}
 /// 	\endcode
 ///
 /// 	"message" - A descriptive error or informational message from the operation. Usually empty on success.
+/// 	"truncated" - Whether the replica was modified.
+/// 	"method" - "native" or "copy". How the data was truncated. Only present if "truncated" is true.
+/// 	"data_truncated" - Present and true once the replica's data has been truncated. If the request failed
+/// 	 anyway, the catalog or the resources were not brought up to date, and the catalog may be inconsistent
+/// 	 with the data.
+/// 	"replica_number" - The replica targeted for truncate. Absent if no replica could be chosen.
+/// 	"resource_hierarchy" - The hierarchy of the replica targeted for truncate. Absent if no replica could be chosen.
+/// 	"deadline_exceeded" - Present and true if the request was abandoned because "truncate_deadline" passed.
+/// 	"size" - The size chosen for the replica. Only present if "truncate_to_delimiter" was used.
+/// 	"snapshot" - The "logical_path", "physical_path", and "resource_hierarchy" of the snapshot made by
+/// 	 "truncate_snapshot", and whether it was made by "clone" or "copy" as "method".
+/// 	"tiers" - Present if the replica is in a compound resource. Maps "cache" and "archive" to the state of the
+/// 	 replica on that tier: "truncated", "replicated" (the compound resource copies the truncated cache replica to
+/// 	 the archive), or "stale". A tier without a replica is absent.
+/// 	"replayed" - Present and true if this is the stored result of an earlier request with the same
+/// 	 "truncate_request_id". Failures are only stored if "data_truncated" is set. Results too large to
+/// 	 store are reduced to their top-level values, and "output_reduced" is set.
+///
+/// 	When "truncate_collection" or "truncate_manifest" is used, "truncated" is replaced by the following:
+/// 	\code{.js}
+/// 	{
+/// 	    "summary": {"matched": <integer>, "truncated": <integer>, "skipped": <integer>, "failed": <integer>},
+/// 	    "failures": [{"path": "<string>", "error_code": <integer>, "message": "<string>"}],
+/// 	    "failures_truncated": <boolean>
+/// 	}
+/// 	\endcode
+///
+/// 	Only the first 1000 failures are listed. "failures_truncated" is true if more failures occurred.
+///
+/// 	With "truncate_defer_notifications", "notifications" is also present and holds the number of replicas whose
+/// 	notifications were "deferred", and how many of them were "delivered" or "failed".
+///
+/// 	When "truncate_stats" is used, the output contains an "admission_control" object mapping each resource under
+/// 	admission control to its "active" and "waiting" counts and per-lane "admitted", "timed_out",
+/// 	"total_queue_delay_us", and "max_queue_delay_us" counters. It also contains a "usage_ledger" object with the
+/// 	signed byte change per leaf resource and owner caused by truncates on this server since "since". The ledger is
+/// 	kept in shared memory on each server, so it only covers truncates performed by the server which was asked:
+/// 	\code{.js}
+/// 	{
+/// 	    "since": <integer>,
+/// 	    "overflowed": <integer>,
+/// 	    "resources": {"<resource>": {"<user>#<zone>": {"bytes": <integer>, "truncates": <integer>}}}
+/// 	}
+/// 	\endcode
 /// \endparblock
 ///
 /// \return iRODS error code.
@@ -0,0 +1,433 @@
+#include "irods/plugins/api/private/admission_control.hpp"
+
+#include "irods/plugins/api/private/configuration.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/shared_memory.hpp"
+
+#include <irods/rodsDef.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace irods::replica_truncate::detail
+{
+	// Lives in shared memory, so it must only contain trivially copyable data.
+	struct admission_entry
+	{
+		// Zero when the entry is free. Entries of agents which died are freed by whoever notices first.
+		pid_t pid{};
+		priority lane{};
+		bool active{};
+	}; // struct admission_entry
+
+	struct lane_counters
+	{
+		std::uint64_t admitted{};
+		std::uint64_t timed_out{};
+		std::uint64_t total_delay_us{};
+		std::uint64_t max_delay_us{};
+	}; // struct lane_counters
+
+	struct admission_state
+	{
+		bool in_use{};
+		std::array<char, NAME_LEN> resource{};
+
+		// Token bucket for the rate limit. Refilled lazily by whichever agent looks at it.
+		double tokens{};
+		std::int64_t last_refill_ns{};
+
+		std::array<admission_entry, 128> entries{};
+		std::array<lane_counters, 2> counters{};
+	}; // struct admission_state
+} // namespace irods::replica_truncate::detail
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	namespace shm = irods::replica_truncate::shared_memory;
+	using irods::replica_truncate::priority;
+	using irods::replica_truncate::detail::admission_entry;
+	using irods::replica_truncate::detail::admission_state;
+	using irods::replica_truncate::detail::lane_counters;
+
+	constexpr const char* table_name = "admission_table";
+	constexpr auto lock_timeout = std::chrono::seconds{5};
+	constexpr auto poll_interval = std::chrono::milliseconds{100};
+
+	struct admission_table
+	{
+		shm::mutex_type mutex;
+		shm::condition_type changed;
+		std::array<admission_state, 64> resources{};
+	}; // struct admission_table
+
+	struct limits
+	{
+		std::string resource;
+		int max_concurrent;
+		int max_concurrent_bulk;
+		double max_per_second;
+		std::chrono::milliseconds max_wait;
+	}; // struct limits
+
+	auto table() -> admission_table&
+	{
+		static auto& table = shm::find_or_construct<admission_table>(table_name);
+		return table;
+	} // table
+
+	auto now_ns() -> std::int64_t
+	{
+		// CLOCK_MONOTONIC is system-wide, so values are comparable across agents.
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				   std::chrono::steady_clock::now().time_since_epoch())
+		    .count();
+	} // now_ns
+
+	// Find the limits of the resource closest to the leaf of the hierarchy which has any.
+	auto find_limits(std::string_view _hierarchy) -> std::optional<limits>
+	{
+		const auto& config = irods::replica_truncate::plugin_configuration();
+
+		const auto ac = config.find("admission_control");
+		if (ac == config.end()) {
+			return std::nullopt;
+		}
+
+		const auto resources = ac->find("resources");
+		if (resources == ac->end()) {
+			return std::nullopt;
+		}
+
+		while (!_hierarchy.empty()) {
+			const auto pos = _hierarchy.rfind(';');
+			const auto resource = std::string{pos == std::string_view::npos ? _hierarchy : _hierarchy.substr(pos + 1)};
+
+			if (const auto r = resources->find(resource); r != resources->end()) {
+				const auto max_concurrent = r->value("max_concurrent", 0);
+
+				return limits{
+					.resource = resource,
+					.max_concurrent = max_concurrent,
+					.max_concurrent_bulk = r->value("max_concurrent_bulk", max_concurrent),
+					.max_per_second = r->value("max_per_second", 0.0),
+					.max_wait = std::chrono::seconds{ac->value("max_wait_in_seconds", 60)}};
+			}
+
+			_hierarchy = pos == std::string_view::npos ? std::string_view{} : _hierarchy.substr(0, pos);
+		}
+
+		return std::nullopt;
+	} // find_limits
+
+	auto find_or_allocate_state(admission_table& _table, const std::string& _resource) -> admission_state*
+	{
+		auto itr = std::find_if(std::begin(_table.resources), std::end(_table.resources), [&_resource](const auto& _s) {
+			return _s.in_use && _resource == _s.resource.data();
+		});
+
+		if (itr != std::end(_table.resources)) {
+			return &*itr;
+		}
+
+		itr = std::find_if(
+			std::begin(_table.resources), std::end(_table.resources), [](const auto& _s) { return !_s.in_use; });
+
+		if (itr == std::end(_table.resources)) {
+			return nullptr;
+		}
+
+		*itr = admission_state{};
+		itr->in_use = true;
+		std::strncpy(itr->resource.data(), _resource.c_str(), itr->resource.size() - 1);
+		itr->last_refill_ns = now_ns();
+
+		return &*itr;
+	} // find_or_allocate_state
+
+	auto prune_dead_entries(admission_state& _state) -> bool
+	{
+		bool pruned = false;
+
+		for (auto& e : _state.entries) {
+			if (0 != e.pid && !shm::process_exists(e.pid)) {
+				e = admission_entry{};
+				pruned = true;
+			}
+		}
+
+		return pruned;
+	} // prune_dead_entries
+
+	auto refill_tokens(admission_state& _state, const limits& _limits) -> void
+	{
+		const auto now = now_ns();
+		const auto elapsed_seconds = static_cast<double>(now - _state.last_refill_ns) / 1e9;
+		const auto burst = std::max(1.0, _limits.max_per_second);
+
+		_state.tokens = std::min(burst, _state.tokens + elapsed_seconds * _limits.max_per_second);
+		_state.last_refill_ns = now;
+	} // refill_tokens
+
+	auto may_proceed(const admission_state& _state, const limits& _limits, priority _lane) -> bool
+	{
+		int active{};
+		int active_bulk{};
+		int interactive_waiting{};
+
+		for (const auto& e : _state.entries) {
+			if (0 == e.pid) {
+				continue;
+			}
+
+			if (e.active) {
+				++active;
+				active_bulk += priority::bulk == e.lane ? 1 : 0;
+			}
+			else if (priority::interactive == e.lane) {
+				++interactive_waiting;
+			}
+		}
+
+		if (_limits.max_concurrent > 0 && active >= _limits.max_concurrent) {
+			return false;
+		}
+
+		// Bulk requests have their own ceiling and always yield to waiting interactive requests.
+		if (priority::bulk == _lane) {
+			if (interactive_waiting > 0) {
+				return false;
+			}
+
+			if (_limits.max_concurrent_bulk > 0 && active_bulk >= _limits.max_concurrent_bulk) {
+				return false;
+			}
+		}
+
+		return _limits.max_per_second <= 0 || _state.tokens >= 1.0;
+	} // may_proceed
+
+	// Wake up periodically even without notifications so that tokens are refilled and dead agents pruned.
+	auto wait_for_change(admission_table& _table, shm::lock_type& _lock, std::chrono::steady_clock::duration _remaining)
+		-> void
+	{
+		const auto wait_for = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::min<std::chrono::steady_clock::duration>(poll_interval, _remaining));
+		_table.changed.timed_wait(_lock,
+		                          boost::posix_time::microsec_clock::universal_time() +
+		                              boost::posix_time::milliseconds(wait_for.count()));
+	} // wait_for_change
+
+	auto record_delay(lane_counters& _counters, std::chrono::microseconds _delay) -> void
+	{
+		const auto us = static_cast<std::uint64_t>(_delay.count());
+		_counters.total_delay_us += us;
+		_counters.max_delay_us = std::max(_counters.max_delay_us, us);
+	} // record_delay
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto to_priority(std::string_view _value) noexcept -> priority
+	{
+		return "bulk" == _value ? priority::bulk : priority::interactive;
+	} // to_priority
+
+	admission_permit::admission_permit(std::string_view _hierarchy, priority _priority, const deadline& _deadline)
+	{
+		auto lim = find_limits(_hierarchy);
+		if (!lim) {
+			admitted_ = true;
+			return;
+		}
+
+		lim->max_wait = _deadline.cap(lim->max_wait);
+
+		resource_ = lim->resource;
+
+		admission_table* t{};
+
+		// Without the table, nothing enforces the limits, so the request is rejected rather than let through.
+		try {
+			t = &table();
+		}
+		catch (const boost::interprocess::interprocess_exception& e) {
+			logging::error(logging::category::admission,
+			               "{}: Could not open shared memory. Rejecting truncate in [{}]. [{}]",
+			               __func__,
+			               resource_,
+			               e.what());
+			return;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto give_up_at = start + lim->max_wait;
+
+		auto lock = shm::lock_for(t->mutex, lock_timeout);
+		if (!lock) {
+			logging::warn(logging::category::admission,
+			              "{}: Timed out waiting for admission table lock. Rejecting truncate in [{}].",
+			              __func__,
+			              resource_);
+			queue_delay_ =
+				std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			return;
+		}
+
+		// Resources keep their state once allocated, so waiting would not make room for another one.
+		auto* state = find_or_allocate_state(*t, resource_);
+		if (!state) {
+			logging::error(logging::category::admission,
+			               "{}: Admission table is full. Rejecting truncate in [{}].",
+			               __func__,
+			               resource_);
+			return;
+		}
+
+		auto& counters = state->counters.at(static_cast<std::size_t>(_priority));
+
+		// Every queue slot is taken. Slots are freed as agents finish, so wait for one as long as the request would
+		// wait for admission.
+		auto entry = std::end(state->entries);
+
+		while (true) {
+			prune_dead_entries(*state);
+
+			entry = std::find_if(
+				std::begin(state->entries), std::end(state->entries), [](const auto& _e) { return 0 == _e.pid; });
+			if (entry != std::end(state->entries)) {
+				break;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			if (now >= give_up_at) {
+				logging::warn(logging::category::admission,
+				              "{}: Too many agents queued on [{}]. Timed out waiting for a slot.",
+				              __func__,
+				              resource_);
+				queue_delay_ = std::chrono::duration_cast<std::chrono::microseconds>(now - start);
+
+				++counters.timed_out;
+				record_delay(counters, queue_delay_);
+
+				return;
+			}
+
+			wait_for_change(*t, lock, give_up_at - now);
+		}
+
+		*entry = admission_entry{.pid = getpid(), .lane = _priority, .active = false};
+		entry_index_ = static_cast<std::size_t>(std::distance(std::begin(state->entries), entry));
+		state_ = state;
+
+		while (true) {
+			refill_tokens(*state, *lim);
+
+			if (may_proceed(*state, *lim, _priority)) {
+				if (lim->max_per_second > 0) {
+					state->tokens -= 1.0;
+				}
+
+				entry->active = true;
+				admitted_ = true;
+				queue_delay_ =
+					std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+				++counters.admitted;
+				record_delay(counters, queue_delay_);
+
+				return;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			if (now >= give_up_at) {
+				*entry = admission_entry{};
+				state_ = nullptr;
+				queue_delay_ = std::chrono::duration_cast<std::chrono::microseconds>(now - start);
+
+				++counters.timed_out;
+				record_delay(counters, queue_delay_);
+
+				// Removing a waiting interactive request may let a bulk request through.
+				t->changed.notify_all();
+
+				return;
+			}
+
+			wait_for_change(*t, lock, give_up_at - now);
+
+			if (prune_dead_entries(*state)) {
+				t->changed.notify_all();
+			}
+		}
+	} // admission_permit
+
+	admission_permit::~admission_permit()
+	{
+		if (!state_) {
+			return;
+		}
+
+		try {
+			auto& t = table();
+			auto lock = shm::lock_for(t.mutex, lock_timeout);
+
+			// If the lock cannot be acquired, the entry is pruned once this agent exits.
+			if (lock) {
+				state_->entries.at(entry_index_) = detail::admission_entry{};
+				t.changed.notify_all();
+			}
+		}
+		catch (...) {
+		}
+	} // ~admission_permit
+
+	auto admission_statistics() -> nlohmann::json
+	{
+		auto stats = nlohmann::json::object();
+
+		auto& t = table();
+		auto lock = shm::lock_for(t.mutex, lock_timeout);
+		if (!lock) {
+			return stats;
+		}
+
+		for (auto& state : t.resources) {
+			if (!state.in_use) {
+				continue;
+			}
+
+			prune_dead_entries(state);
+
+			const auto count = [&state](bool _active) {
+				return std::count_if(std::begin(state.entries), std::end(state.entries), [_active](const auto& _e) {
+					return 0 != _e.pid && _active == _e.active;
+				});
+			};
+
+			auto lanes = nlohmann::json::object();
+			for (const auto& [name, lane] : {std::pair{"interactive", priority::interactive},
+			                                 std::pair{"bulk", priority::bulk}})
+			{
+				const auto& c = state.counters.at(static_cast<std::size_t>(lane));
+				lanes[name] = {{"admitted", c.admitted},
+				               {"timed_out", c.timed_out},
+				               {"total_queue_delay_us", c.total_delay_us},
+				               {"max_queue_delay_us", c.max_delay_us}};
+			}
+
+			stats[state.resource.data()] = {{"active", count(true)}, {"waiting", count(false)}, {"lanes", lanes}};
+		}
+
+		return stats;
+	} // admission_statistics
+} // namespace irods::replica_truncate
@@ -0,0 +1,119 @@
+#include "irods/plugins/api/private/batch.hpp"
+
+#include "irods/plugins/api/private/truncate_replica.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/irods_exception.hpp>
+#include <irods/objInfo.h>
+#include <irods/rcMisc.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rodsKeyWdDef.h>
+
+#include <fmt/format.h>
+
+#include <string>
+
+namespace
+{
+	// Listing every failure for a batch with millions of entries would produce an enormous response, so only the
+	// first few are reported. The summary still counts all of them.
+	constexpr std::size_t max_failures_reported = 1000;
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto truncate_batch_entry(RsComm& _comm,
+	                          const DataObjInp& _template,
+	                          const batch_entry& _entry,
+	                          deferred_notifications* _deferred,
+	                          nlohmann::json& _output) -> int
+	{
+		if (_entry.logical_path.empty() || _entry.logical_path.size() >= sizeof(DataObjInp::objPath)) {
+			_output["message"] = "Invalid logical path.";
+			return SYS_INVALID_INPUT_PARAM;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_cond_input{[&input] { clearKeyVal(&input.condInput); }};
+
+		copy_into(input.objPath, _entry.logical_path);
+		input.dataSize = _entry.size;
+		replKeyVal(&_template.condInput, &input.condInput);
+
+		// These keywords describe the batch, not the individual objects.
+		rmKeyVal(&input.condInput, TRUNCATE_COLLECTION_KW);
+		rmKeyVal(&input.condInput, TRUNCATE_MANIFEST_KW);
+		rmKeyVal(&input.condInput, TRUNCATE_NAME_LIKE_KW);
+		rmKeyVal(&input.condInput, TRUNCATE_ONLY_IF_LARGER_KW);
+		rmKeyVal(&input.condInput, TRUNCATE_PAGE_SIZE_KW);
+		rmKeyVal(&input.condInput, TRUNCATE_DEFER_NOTIFICATIONS_KW);
+		rmKeyVal(&input.condInput, TRUNCATE_REQUEST_ID_KW);
+
+		if (_entry.replica_number) {
+			rmKeyVal(&input.condInput, RESC_NAME_KW);
+			addKeyVal(&input.condInput, REPL_NUM_KW, std::to_string(*_entry.replica_number).c_str());
+		}
+		else if (!_entry.resource.empty()) {
+			rmKeyVal(&input.condInput, REPL_NUM_KW);
+			addKeyVal(&input.condInput, RESC_NAME_KW, std::string{_entry.resource}.c_str());
+		}
+
+		// Batches are usually submitted by retention jobs, which should not get in the way of interactive users.
+		if (!getValByKey(&input.condInput, TRUNCATE_PRIORITY_KW)) {
+			addKeyVal(&input.condInput, TRUNCATE_PRIORITY_KW, "bulk");
+		}
+
+		try {
+			return truncate_replica(_comm, input, _output, _deferred);
+		}
+		catch (const irods::exception& e) {
+			_output["message"] = fmt::format("iRODS exception occurred: [{}]", e.client_display_what());
+			return static_cast<int>(e.code());
+		}
+		catch (const std::exception& e) {
+			_output["message"] = fmt::format("std::exception occurred: [{}]", e.what());
+			return SYS_INTERNAL_ERR;
+		}
+	} // truncate_batch_entry
+
+	auto batch_results::add(std::string_view _logical_path, int _ec, const nlohmann::json& _object_output) -> void
+	{
+		if (_ec < 0) {
+			add_failure(_logical_path, _ec, _object_output.value("message", ""));
+			return;
+		}
+
+		++matched_;
+
+		if (_object_output.value("truncated", false)) {
+			++truncated_;
+		}
+		else {
+			++skipped_;
+		}
+	} // batch_results::add
+
+	auto batch_results::add_failure(std::string_view _logical_path, int _ec, std::string_view _message) -> void
+	{
+		++matched_;
+		++failed_;
+
+		if (0 == first_error_) {
+			first_error_ = _ec;
+		}
+
+		if (failures_.size() < max_failures_reported) {
+			failures_.push_back({{"path", _logical_path}, {"error_code", _ec}, {"message", _message}});
+		}
+	} // batch_results::add_failure
+
+	auto batch_results::write(nlohmann::json& _output) const -> void
+	{
+		_output["summary"] = {
+			{"matched", matched_}, {"truncated", truncated_}, {"skipped", skipped_}, {"failed", failed_}};
+		_output["failures"] = failures_;
+		_output["failures_truncated"] = failed_ > failures_.size();
+	} // batch_results::write
+} // namespace irods::replica_truncate
@@ -0,0 +1,389 @@
+#include "irods/plugins/api/private/coalesced_truncate.hpp"
+
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/shared_memory.hpp"
+
+#include <irods/rodsDef.h>
+#include <irods/rodsErrorTable.h>
+
+#include <fmt/format.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace irods::replica_truncate::detail
+{
+	// Lives in shared memory, so it must only contain trivially copyable data.
+	struct coalescing_slot
+	{
+		bool in_use{};
+		std::array<char, 2 * MAX_NAME_LEN> key{};
+
+		// The agent currently truncating the replica. Zero when there is none.
+		pid_t leader_pid{};
+		std::uint64_t leader_ticket{};
+		rodsLong_t leader_size{};
+
+		// Every distinct request receives a ticket. Identical requests share one.
+		std::uint64_t next_ticket{};
+		std::uint64_t latest_ticket{};
+		rodsLong_t latest_size{};
+		// The agent which most recently asked for latest_ticket, and which will lead it unless another agent sharing
+		// the ticket gets there first. Zero once it stopped waiting without leading.
+		pid_t latest_pid{};
+
+		// The result of the most recently completed truncate. Every ticket up to served_ticket has been answered.
+		std::uint64_t served_ticket{};
+		rodsLong_t served_size{};
+		int served_ec{};
+		bool served_truncated{};
+
+		// Tickets up to this one belonged to a leader which died. They will never be served.
+		std::uint64_t abandoned_ticket{};
+
+		int waiters{};
+	}; // struct coalescing_slot
+} // namespace irods::replica_truncate::detail
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	namespace shm = irods::replica_truncate::shared_memory;
+	using irods::replica_truncate::detail::coalescing_slot;
+
+	constexpr const char* table_name = "coalescing_table";
+
+	// Bounds the number of distinct replicas which can be coordinated at once. Truncates beyond that proceed
+	// uncoordinated.
+	constexpr std::size_t slot_count = 256;
+
+	constexpr auto lock_timeout = std::chrono::seconds{5};
+
+	// How long a follower waits before giving up and proceeding on its own. Also how often it checks that the leader
+	// is still alive.
+	constexpr auto wait_timeout = std::chrono::minutes{5};
+	constexpr auto poll_interval = std::chrono::seconds{1};
+
+	struct coalescing_table
+	{
+		shm::mutex_type mutex;
+		shm::condition_type changed;
+		std::array<coalescing_slot, slot_count> slots{};
+	}; // struct coalescing_table
+
+	auto table() -> coalescing_table&
+	{
+		static auto& table = shm::find_or_construct<coalescing_table>(table_name);
+		return table;
+	} // table
+
+	auto find_slot(coalescing_table& _table, std::string_view _key) -> coalescing_slot*
+	{
+		const auto itr = std::find_if(std::begin(_table.slots), std::end(_table.slots), [&_key](const auto& _s) {
+			return _s.in_use && _key == _s.key.data();
+		});
+
+		return itr == std::end(_table.slots) ? nullptr : &*itr;
+	} // find_slot
+
+	auto allocate_slot(coalescing_table& _table, std::string_view _key) -> coalescing_slot*
+	{
+		// Slots left behind by a leader which died with nobody waiting on it are reclaimed here.
+		const auto itr = std::find_if(std::begin(_table.slots), std::end(_table.slots), [](const auto& _s) {
+			return !_s.in_use || (0 == _s.waiters && 0 != _s.leader_pid && !shm::process_exists(_s.leader_pid));
+		});
+
+		if (itr == std::end(_table.slots)) {
+			return nullptr;
+		}
+
+		*itr = coalescing_slot{};
+		itr->in_use = true;
+		std::memcpy(itr->key.data(), _key.data(), _key.size());
+
+		return &*itr;
+	} // allocate_slot
+
+	auto release_slot_if_idle(coalescing_slot& _slot) -> void
+	{
+		if (0 == _slot.leader_pid && 0 == _slot.waiters) {
+			_slot.in_use = false;
+		}
+	} // release_slot_if_idle
+
+	auto lead(coalescing_slot& _slot, std::uint64_t _ticket, rodsLong_t _size) -> void
+	{
+		_slot.leader_pid = getpid();
+		_slot.leader_ticket = _ticket;
+		_slot.leader_size = _size;
+	} // lead
+
+	auto publish(coalescing_table& _table, coalescing_slot& _slot, std::uint64_t _ticket, int _ec, bool _truncated)
+		-> void
+	{
+		// The followers may have given up on this agent and moved on in the meantime.
+		if (getpid() != _slot.leader_pid || _ticket != _slot.leader_ticket) {
+			return;
+		}
+
+		_slot.served_ticket = _ticket;
+		_slot.served_size = _slot.leader_size;
+		_slot.served_ec = _ec;
+		_slot.served_truncated = _truncated;
+		_slot.leader_pid = 0;
+		release_slot_if_idle(_slot);
+
+		_table.changed.notify_all();
+	} // publish
+
+	// A result which could not be published because the table lock could not be acquired. This agent is still the
+	// leader as far as its followers can tell, so the result is published the next time it holds the lock.
+	struct unpublished_result
+	{
+		coalescing_slot* slot;
+		std::uint64_t ticket;
+		int ec;
+		bool truncated;
+	}; // struct unpublished_result
+
+	auto unpublished_results() -> std::vector<unpublished_result>&
+	{
+		static std::vector<unpublished_result> results;
+		return results;
+	} // unpublished_results
+
+	auto publish_unpublished_results(coalescing_table& _table) -> void
+	{
+		auto& results = unpublished_results();
+
+		for (const auto& r : results) {
+			publish(_table, *r.slot, r.ticket, r.ec, r.truncated);
+		}
+
+		results.clear();
+	} // publish_unpublished_results
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	coalesced_truncate::coalesced_truncate(std::string_view _user,
+	                                       std::string_view _logical_path,
+	                                       int _replica_number,
+	                                       rodsLong_t _size,
+	                                       const deadline& _deadline)
+	{
+		// The user is part of the key so that one user never receives the result of another user's request.
+		// The key is built on the stack because it is only ever compared with and copied into the table.
+		decltype(detail::coalescing_slot::key) key_buffer{};
+		const auto [end, size] = fmt::format_to_n(
+			key_buffer.data(), key_buffer.size() - 1, "{}:{}:{}", _user, _replica_number, _logical_path);
+		if (size >= key_buffer.size()) {
+			return;
+		}
+
+		const std::string_view key{key_buffer.data(), size};
+
+		coalescing_table* t{};
+
+		try {
+			t = &table();
+		}
+		catch (const boost::interprocess::interprocess_exception& e) {
+			logging::warn(logging::category::coalescing,
+			              "{}: Could not open shared memory. Proceeding uncoordinated. [{}]",
+			              __func__,
+			              e.what());
+			return;
+		}
+
+		auto lock = shm::lock_for(t->mutex, lock_timeout);
+		if (!lock) {
+			logging::warn(logging::category::coalescing,
+			              "{}: Timed out waiting for coalescing table lock. Proceeding uncoordinated.",
+			              __func__);
+			return;
+		}
+
+		// Otherwise, a request for a replica whose result this agent failed to publish would wait on itself.
+		publish_unpublished_results(*t);
+
+		auto* slot = find_slot(*t, key);
+
+		if (!slot) {
+			slot = allocate_slot(*t, key);
+
+			if (slot) {
+				lead(*slot, ++slot->next_ticket, _size);
+				slot_ = slot;
+				ticket_ = slot->leader_ticket;
+				role_ = role::leader;
+			}
+
+			return;
+		}
+
+		// Decide which truncate will answer this request.
+		std::uint64_t ticket{};
+		if (0 != slot->leader_pid && slot->leader_size == _size) {
+			ticket = slot->leader_ticket;
+		}
+		else if (slot->latest_ticket > slot->served_ticket && slot->latest_ticket > slot->abandoned_ticket &&
+		         slot->latest_ticket != slot->leader_ticket && slot->latest_size == _size)
+		{
+			ticket = slot->latest_ticket;
+			slot->latest_pid = getpid();
+		}
+		else {
+			ticket = ++slot->next_ticket;
+			slot->latest_ticket = ticket;
+			slot->latest_size = _size;
+			slot->latest_pid = getpid();
+		}
+
+		++slot->waiters;
+
+		// A follower never waits past the client's deadline, however long the truncates ahead of it take.
+		const auto give_up_at = std::chrono::steady_clock::now() +
+		                        _deadline.cap(std::chrono::duration_cast<std::chrono::milliseconds>(wait_timeout));
+
+		// Stop waiting without leading. If nobody else is left to lead the latest ticket, the agents whose requests it
+		// superseded must not wait for it.
+		const auto leave = [&slot, ticket] {
+			--slot->waiters;
+
+			if (slot->latest_ticket == ticket && slot->latest_pid == getpid()) {
+				slot->latest_pid = 0;
+			}
+
+			release_slot_if_idle(*slot);
+		};
+
+		while (true) {
+			if (slot->served_ticket >= ticket) {
+				--slot->waiters;
+				release_slot_if_idle(*slot);
+
+				shared_ec_ = slot->served_ec;
+				shared_truncated_ = slot->served_truncated;
+				shared_size_ = slot->served_size;
+				role_ = role::follower;
+
+				return;
+			}
+
+			if (ticket <= slot->abandoned_ticket) {
+				leave();
+				return;
+			}
+
+			if (0 == slot->leader_pid && slot->latest_ticket == ticket) {
+				--slot->waiters;
+
+				if (slot->served_ticket > 0 && slot->served_ec >= 0) {
+					size_after_wait_ = slot->served_size;
+				}
+
+				lead(*slot, ticket, _size);
+				slot_ = slot;
+				ticket_ = ticket;
+				role_ = role::leader;
+
+				return;
+			}
+
+			if (0 != slot->leader_pid && !shm::process_exists(slot->leader_pid)) {
+				logging::warn(logging::category::coalescing,
+				              "{}: Agent [{}] truncating [{}] exited without publishing a result.",
+				              __func__,
+				              slot->leader_pid,
+				              _logical_path);
+
+				// Nobody will ever answer the abandoned ticket, so its followers are on their own.
+				slot->abandoned_ticket = slot->leader_ticket;
+				slot->leader_pid = 0;
+				t->changed.notify_all();
+
+				continue;
+			}
+
+			// A superseded request waits for the latest one, which is only led once the current leader is done. If
+			// the agent which would lead it died or gave up, nobody will.
+			if (0 == slot->leader_pid && slot->latest_ticket > std::max(slot->served_ticket, slot->abandoned_ticket) &&
+			    (0 == slot->latest_pid || !shm::process_exists(slot->latest_pid)))
+			{
+				logging::warn(logging::category::coalescing,
+				              "{}: Agent [{}] queued to truncate [{}] is gone.",
+				              __func__,
+				              slot->latest_pid,
+				              _logical_path);
+
+				slot->abandoned_ticket = slot->latest_ticket;
+				t->changed.notify_all();
+
+				continue;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			if (now >= give_up_at) {
+				logging::warn(logging::category::coalescing,
+				              "{}: Timed out waiting on concurrent truncate of [{}]. Proceeding uncoordinated.",
+				              __func__,
+				              _logical_path);
+				leave();
+				t->changed.notify_all();
+				return;
+			}
+
+			const auto wait_for = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::min<std::chrono::steady_clock::duration>(poll_interval, give_up_at - now));
+			t->changed.timed_wait(lock,
+			                      boost::posix_time::microsec_clock::universal_time() +
+			                          boost::posix_time::milliseconds(wait_for.count()));
+		}
+	} // coalesced_truncate
+
+	coalesced_truncate::~coalesced_truncate()
+	{
+		if (role::leader == role_ && !completed_) {
+			try {
+				complete(SYS_INTERNAL_ERR, false);
+			}
+			catch (...) {
+			}
+		}
+	} // ~coalesced_truncate
+
+	auto coalesced_truncate::complete(int _ec, bool _truncated) -> void
+	{
+		if (role::leader != role_ || completed_) {
+			return;
+		}
+
+		completed_ = true;
+
+		auto& t = table();
+		auto lock = shm::lock_for(t.mutex, lock_timeout);
+		if (!lock) {
+			// The followers keep waiting on this agent until it publishes the result the next time it holds the
+			// lock, it exits, or they time out.
+			logging::warn(logging::category::coalescing,
+			              "{}: Timed out waiting for coalescing table lock. Result will be published later.",
+			              __func__);
+			unpublished_results().push_back({.slot = slot_, .ticket = ticket_, .ec = _ec, .truncated = _truncated});
+			return;
+		}
+
+		publish_unpublished_results(t);
+		publish(t, *slot_, ticket_, _ec, _truncated);
+	} // complete
+} // namespace irods::replica_truncate
@@ -0,0 +1,143 @@
+#include "irods/plugins/api/private/compound_tiers.hpp"
+
+#include "irods/plugins/api/private/configuration.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/irods_resource_backport.hpp>
+#include <irods/irods_resource_constants.hpp>
+#include <irods/objInfo.h>
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::compound_position;
+	using irods::replica_truncate::compound_tier;
+
+	// The values of the parent context of the children of a compound resource.
+	constexpr std::string_view cache_context = "cache";
+	constexpr std::string_view archive_context = "archive";
+
+	auto compound_section() -> const nlohmann::json&
+	{
+		static const auto empty = nlohmann::json::object();
+
+		const auto& config = irods::replica_truncate::plugin_configuration();
+		const auto section = config.find("compound");
+
+		return section != config.end() && section->is_object() ? *section : empty;
+	} // compound_section
+
+	auto resource_property(const std::string& _resource, const std::string& _property) -> std::string
+	{
+		std::string value;
+
+		if (const auto ret = irods::get_resource_property<std::string>(_resource, _property, value); !ret.ok()) {
+			logging::debug(logging::category::selection,
+			               "{}: Could not get property [{}] of resource [{}].",
+			               __func__,
+			               _property,
+			               _resource);
+			return {};
+		}
+
+		return value;
+	} // resource_property
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto to_string(compound_tier _tier) noexcept -> const char*
+	{
+		return compound_tier::cache == _tier ? "cache" : "archive";
+	} // to_string
+
+	auto truncates_tiers_in_place() -> bool
+	{
+		return compound_section().value("truncate_tiers_in_place", false);
+	} // truncates_tiers_in_place
+
+	auto find_compound_position(std::string_view _hierarchy) -> std::optional<compound_position>
+	{
+		std::string_view::size_type start = 0;
+
+		while (start < _hierarchy.size()) {
+			const auto end = std::min(_hierarchy.find(';', start), _hierarchy.size());
+			const auto resource = std::string{_hierarchy.substr(start, end - start)};
+
+			// The compound resource must have a child for the hierarchy to name a tier.
+			if (end < _hierarchy.size() && "compound" == resource_property(resource, irods::RESOURCE_TYPE)) {
+				const auto child_end = std::min(_hierarchy.find(';', end + 1), _hierarchy.size());
+				const auto child = std::string{_hierarchy.substr(end + 1, child_end - end - 1)};
+				const auto context = resource_property(child, irods::RESOURCE_PARENT_CONTEXT);
+
+				if (cache_context == context || archive_context == context) {
+					return compound_position{
+						.compound_hierarchy = std::string{_hierarchy.substr(0, end)},
+						.tier = cache_context == context ? compound_tier::cache : compound_tier::archive};
+				}
+
+				return std::nullopt;
+			}
+
+			start = end + 1;
+		}
+
+		return std::nullopt;
+	} // find_compound_position
+
+	auto find_other_tier(DataObjInfo* _replicas, const compound_position& _position) -> DataObjInfo*
+	{
+		const auto prefix = _position.compound_hierarchy + ';';
+
+		for (auto* replica = _replicas; replica; replica = replica->next) {
+			if (!std::string_view{replica->rescHier}.starts_with(prefix)) {
+				continue;
+			}
+
+			if (const auto other = find_compound_position(replica->rescHier); other && other->tier != _position.tier)
+			{
+				return replica;
+			}
+		}
+
+		return nullptr;
+	} // find_other_tier
+
+	auto archive_can_truncate(std::string_view _hierarchy) -> bool
+	{
+		const auto& section = compound_section();
+
+		auto types = nlohmann::json::array({"unixfilesystem"});
+		if (const auto t = section.find("archive_types_with_truncate"); t != section.end() && t->is_array()) {
+			types = *t;
+		}
+
+		const auto type = resource_property(std::string{leaf_of(_hierarchy)}, irods::RESOURCE_TYPE);
+
+		return !type.empty() && std::find(std::begin(types), std::end(types), type) != std::end(types);
+	} // archive_can_truncate
+
+	auto select_archive_only_replica(const DataObjInfo* _replicas) -> const DataObjInfo*
+	{
+		if (!_replicas || _replicas->next) {
+			// Any other replica means there is either a cache replica, or a replica outside of the compound resource
+			// which the vote might prefer.
+			return nullptr;
+		}
+
+		const auto position = find_compound_position(_replicas->rescHier);
+		if (!position || compound_tier::archive != position->tier) {
+			return nullptr;
+		}
+
+		if (!is_at_rest(_replicas->replStatus) || !archive_can_truncate(_replicas->rescHier)) {
+			return nullptr;
+		}
+
+		return _replicas;
+	} // select_archive_only_replica
+} // namespace irods::replica_truncate
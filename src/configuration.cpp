@@ -0,0 +1,43 @@
+#include "irods/plugins/api/private/configuration.hpp"
+
+#include <irods/irods_configuration_keywords.hpp>
+#include <irods/irods_exception.hpp>
+#include <irods/irods_logger.hpp>
+#include <irods/irods_server_properties.hpp>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+	using log_api = irods::experimental::log::api;
+
+	auto load_plugin_configuration() -> nlohmann::json
+	{
+		try {
+			// clang-format off
+			return irods::get_server_property<const nlohmann::json&>(std::vector<std::string>{
+				irods::KW_CFG_PLUGIN_CONFIGURATION,
+				"api",
+				"irods_api_plugin_replica_truncate"
+			});
+			// clang-format on
+		}
+		catch (const irods::exception& e) {
+			// The section is optional. Everything has a default.
+			log_api::debug(
+				"{}: No plugin configuration found. Using defaults. [{}]", __func__, e.client_display_what());
+		}
+
+		return nlohmann::json::object();
+	} // load_plugin_configuration
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto plugin_configuration() -> const nlohmann::json&
+	{
+		static const auto config = load_plugin_configuration();
+		return config;
+	} // plugin_configuration
+} // namespace irods::replica_truncate
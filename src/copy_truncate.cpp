@@ -0,0 +1,330 @@
+#include "irods/plugins/api/private/copy_truncate.hpp"
+
+#include "irods/plugins/api/private/configuration.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/fileClose.h>
+#include <irods/fileOpen.h>
+#include <irods/fileRead.h>
+#include <irods/fileRename.h>
+#include <irods/fileStat.h>
+#include <irods/fileUnlink.h>
+#include <irods/fileWrite.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/rcMisc.h>
+#include <irods/rodsDef.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rsFileClose.hpp>
+#include <irods/rsFileOpen.hpp>
+#include <irods/rsFileRead.hpp>
+#include <irods/rsFileRename.hpp>
+#include <irods/rsFileStat.hpp>
+#include <irods/rsFileUnlink.hpp>
+#include <irods/rsFileWrite.hpp>
+
+#include <fmt/format.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::copy_into;
+
+	constexpr int default_buffer_size = 4 * 1024 * 1024;
+	constexpr int min_buffer_size = 64 * 1024;
+	constexpr int max_buffer_size = 64 * 1024 * 1024;
+
+	auto get_buffer_size() -> int
+	{
+		const auto& config = irods::replica_truncate::plugin_configuration();
+
+		const auto section = config.find("copy_fallback");
+		if (section == config.end()) {
+			return default_buffer_size;
+		}
+
+		return std::clamp(
+			section->value("buffer_size_in_bytes", default_buffer_size), min_buffer_size, max_buffer_size);
+	} // get_buffer_size
+
+	// Everything needed to address a file through the resource plugin on the server which hosts it.
+	struct file_location
+	{
+		std::string_view logical_path;
+		std::string_view hierarchy;
+		std::string host;
+	}; // struct file_location
+
+	auto open_file(RsComm& _comm,
+	               const file_location& _location,
+	               std::string_view _physical_path,
+	               int _flags,
+	               int _mode = S_IRUSR | S_IWUSR) -> int
+	{
+		fileOpenInp_t inp{};
+		copy_into(inp.fileName, _physical_path);
+		copy_into(inp.resc_hier_, _location.hierarchy);
+		copy_into(inp.objPath, _location.logical_path);
+		copy_into(inp.addr.hostAddr, _location.host);
+		inp.flags = _flags;
+		inp.mode = _mode;
+
+		return rsFileOpen(&_comm, &inp);
+	} // open_file
+
+	// The copy replaces the original, so it must keep the original's permission bits. Resources which do not report
+	// a mode get the one the open used before.
+	auto file_mode(RsComm& _comm, const file_location& _location, std::string_view _physical_path) -> int
+	{
+		fileStatInp_t inp{};
+		copy_into(inp.fileName, _physical_path);
+		copy_into(inp.rescHier, _location.hierarchy);
+		copy_into(inp.objPath, _location.logical_path);
+		copy_into(inp.addr.hostAddr, _location.host);
+
+		rodsStat_t* out{};
+		const auto ec = rsFileStat(&_comm, &inp, &out);
+		irods::at_scope_exit free_out{[&out] { std::free(out); }}; // NOLINT(cppcoreguidelines-no-malloc)
+
+		if (ec < 0 || !out || 0 == (out->st_mode & 07777)) {
+			return S_IRUSR | S_IWUSR;
+		}
+
+		return static_cast<int>(out->st_mode & 07777);
+	} // file_mode
+
+	auto close_file(RsComm& _comm, int _fd) -> int
+	{
+		fileCloseInp_t inp{};
+		inp.fileInx = _fd;
+
+		return rsFileClose(&_comm, &inp);
+	} // close_file
+
+	auto unlink_file(RsComm& _comm, const file_location& _location, std::string_view _physical_path) -> int
+	{
+		fileUnlinkInp_t inp{};
+		copy_into(inp.fileName, _physical_path);
+		copy_into(inp.rescHier, _location.hierarchy);
+		copy_into(inp.objPath, _location.logical_path);
+		copy_into(inp.addr.hostAddr, _location.host);
+
+		return rsFileUnlink(&_comm, &inp);
+	} // unlink_file
+
+	auto rename_file(RsComm& _comm,
+	                 const file_location& _location,
+	                 std::string_view _from,
+	                 std::string_view _to) -> int
+	{
+		fileRenameInp_t inp{};
+		copy_into(inp.oldFileName, _from);
+		copy_into(inp.newFileName, _to);
+		copy_into(inp.rescHier, _location.hierarchy);
+		copy_into(inp.objPath, _location.logical_path);
+		copy_into(inp.addr.hostAddr, _location.host);
+
+		fileRenameOut_t* out{};
+		const auto ec = rsFileRename(&_comm, &inp, &out);
+		std::free(out); // NOLINT(cppcoreguidelines-no-malloc)
+
+		return ec;
+	} // rename_file
+
+	auto write_all(RsComm& _comm, int _fd, char* _data, int _length) -> int
+	{
+		fileWriteInp_t inp{};
+		inp.fileInx = _fd;
+		inp.len = _length;
+
+		BytesBuf buf{};
+		buf.buf = _data;
+		buf.len = _length;
+
+		const auto written = rsFileWrite(&_comm, &inp, &buf);
+		if (written < 0) {
+			return written;
+		}
+
+		return written == _length ? 0 : SYS_COPY_LEN_ERR;
+	} // write_all
+
+	// Copy the first _length bytes from _source to _destination, padding with zeros if _source is shorter.
+	auto copy_data(RsComm& _comm, int _source, int _destination, rodsLong_t _length) -> int
+	{
+		const auto buffer_size = get_buffer_size();
+		std::vector<char> buffer(static_cast<std::size_t>(buffer_size));
+
+		rodsLong_t copied = 0;
+
+		while (copied < _length) {
+			const auto want = static_cast<int>(std::min<rodsLong_t>(buffer_size, _length - copied));
+
+			fileReadInp_t inp{};
+			inp.fileInx = _source;
+			inp.len = want;
+
+			BytesBuf buf{};
+			buf.buf = buffer.data();
+			buf.len = want;
+
+			const auto read = rsFileRead(&_comm, &inp, &buf);
+			if (read < 0) {
+				return read;
+			}
+
+			if (0 == read) {
+				break;
+			}
+
+			if (const auto ec = write_all(_comm, _destination, buffer.data(), read); ec < 0) {
+				return ec;
+			}
+
+			copied += read;
+		}
+
+		if (copied < _length) {
+			std::fill(std::begin(buffer), std::end(buffer), '\0');
+
+			while (copied < _length) {
+				const auto n = static_cast<int>(std::min<rodsLong_t>(buffer_size, _length - copied));
+
+				if (const auto ec = write_all(_comm, _destination, buffer.data(), n); ec < 0) {
+					return ec;
+				}
+
+				copied += n;
+			}
+		}
+
+		return 0;
+	} // copy_data
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto is_truncate_unsupported(int _ec) noexcept -> bool
+	{
+		if (SYS_NOT_SUPPORTED == _ec) {
+			return true;
+		}
+
+		const auto err = getErrno(_ec);
+		return ENOTSUP == err || EOPNOTSUPP == err || ENOSYS == err;
+	} // is_truncate_unsupported
+
+	auto copy_physical_data(RsComm& _comm,
+	                        std::string_view _logical_path,
+	                        std::string_view _physical_path,
+	                        std::string_view _hierarchy,
+	                        std::string_view _destination_path,
+	                        rodsLong_t _length) -> int
+	{
+		file_location location{.logical_path = _logical_path, .hierarchy = _hierarchy, .host = {}};
+		if (const auto ec = host_of_hierarchy(_hierarchy, location.host); ec < 0) {
+			return ec;
+		}
+
+		if (_destination_path.size() >= MAX_NAME_LEN || _physical_path.size() >= MAX_NAME_LEN) {
+			return USER_STRLEN_TOOLONG;
+		}
+
+		const auto source = open_file(_comm, location, _physical_path, O_RDONLY);
+		if (source < 0) {
+			return source;
+		}
+
+		irods::at_scope_exit close_source{[&_comm, source] { close_file(_comm, source); }};
+
+		const auto mode = file_mode(_comm, location, _physical_path);
+		const auto destination = open_file(_comm, location, _destination_path, O_WRONLY | O_CREAT | O_EXCL, mode);
+		if (destination < 0) {
+			return destination;
+		}
+
+		bool destination_open = true;
+		bool complete = false;
+
+		irods::at_scope_exit clean_up_copy{[&] {
+			if (destination_open) {
+				close_file(_comm, destination);
+			}
+
+			if (!complete) {
+				unlink_file(_comm, location, _destination_path);
+			}
+		}};
+
+		if (const auto ec = copy_data(_comm, source, destination, _length); ec < 0) {
+			return ec;
+		}
+
+		// The copy must be complete on storage before it is used.
+		destination_open = false;
+		if (const auto ec = close_file(_comm, destination); ec < 0) {
+			return ec;
+		}
+
+		complete = true;
+
+		return 0;
+	} // copy_physical_data
+
+	auto unlink_physical_data(RsComm& _comm,
+	                          std::string_view _logical_path,
+	                          std::string_view _hierarchy,
+	                          std::string_view _physical_path) -> int
+	{
+		file_location location{.logical_path = _logical_path, .hierarchy = _hierarchy, .host = {}};
+		if (const auto ec = host_of_hierarchy(_hierarchy, location.host); ec < 0) {
+			return ec;
+		}
+
+		return unlink_file(_comm, location, _physical_path);
+	} // unlink_physical_data
+
+	auto copy_truncate(RsComm& _comm,
+	                   std::string_view _logical_path,
+	                   std::string_view _physical_path,
+	                   std::string_view _hierarchy,
+	                   rodsLong_t _length) -> int
+	{
+		file_location location{.logical_path = _logical_path, .hierarchy = _hierarchy, .host = {}};
+		if (const auto ec = host_of_hierarchy(_hierarchy, location.host); ec < 0) {
+			return ec;
+		}
+
+		// The copy lives next to the original so that the rename cannot cross file systems.
+		const auto copy_path = fmt::format("{}.truncate.{}", _physical_path, getpid());
+
+		if (const auto ec = copy_physical_data(_comm, _logical_path, _physical_path, _hierarchy, copy_path, _length);
+		    ec < 0)
+		{
+			return ec;
+		}
+
+		if (const auto ec = rename_file(_comm, location, copy_path, _physical_path); ec < 0) {
+			unlink_file(_comm, location, copy_path);
+			return ec;
+		}
+
+		logging::debug(logging::category::request,
+		               "{}: Truncated [{}] to [{}] bytes by copying.",
+		               __func__,
+		               _physical_path,
+		               _length);
+
+		return 0;
+	} // copy_truncate
+} // namespace irods::replica_truncate
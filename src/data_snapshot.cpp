@@ -0,0 +1,241 @@
+#include "irods/plugins/api/private/data_snapshot.hpp"
+
+#include "irods/plugins/api/private/copy_truncate.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/replica_location.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/dataObjInpOut.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/irods_resource_backport.hpp>
+#include <irods/irods_resource_constants.hpp>
+#include <irods/key_value_proxy.hpp>
+#include <irods/objMetaOpr.hpp>
+#include <irods/rcMisc.h>
+#include <irods/rodsDef.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rodsKeyWdDef.h>
+#include <irods/rsDataObjUnlink.hpp>
+#include <irods/rsPhyPathReg.hpp>
+#include <irods/scoped_privileged_client.hpp>
+
+#include <fmt/format.h>
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <utility>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::copy_into;
+	using irods::replica_truncate::snapshot_mode;
+
+	// Only this resource type stores a replica at its physical path on the local file system.
+	auto is_local_unixfilesystem(std::string_view _hierarchy) -> bool
+	{
+		if (!irods::replica_truncate::is_local_hierarchy(_hierarchy)) {
+			return false;
+		}
+
+		const auto leaf = std::string{irods::replica_truncate::leaf_of(_hierarchy)};
+
+		std::string type;
+		const auto ret = irods::get_resource_property<std::string>(leaf, irods::RESOURCE_TYPE, type);
+
+		return ret.ok() && "unixfilesystem" == type;
+	} // is_local_unixfilesystem
+
+	// Whether errno after FICLONE means that the file system cannot clone, rather than that something went wrong.
+	auto is_clone_unsupported(int _errno) noexcept -> bool
+	{
+		return EOPNOTSUPP == _errno || ENOTSUP == _errno || EXDEV == _errno || EINVAL == _errno ||
+		       ENOTTY == _errno || ENOSYS == _errno;
+	} // is_clone_unsupported
+
+	auto clone_file(const std::string& _source, const std::string& _destination) -> int
+	{
+#ifdef FICLONE
+		const auto source = open(_source.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT(cppcoreguidelines-pro-type-vararg)
+		if (source < 0) {
+			return UNIX_FILE_OPEN_ERR - errno;
+		}
+
+		struct stat source_stat{};
+		if (fstat(source, &source_stat) < 0) {
+			const auto err = errno;
+			close(source);
+			return UNIX_FILE_STAT_ERR - err;
+		}
+
+		constexpr auto flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+		const auto destination = open(_destination.c_str(), flags, S_IRUSR | S_IWUSR); // NOLINT(cppcoreguidelines-pro-type-vararg)
+		if (destination < 0) {
+			const auto err = errno;
+			close(source);
+			return UNIX_FILE_OPEN_ERR - err;
+		}
+
+		// The snapshot gets the permission bits of the original, as a copy would. Set after the file is created, so
+		// that the umask does not change them.
+		if (fchmod(destination, source_stat.st_mode & 07777) < 0) {
+			const auto err = errno;
+			close(source);
+			close(destination);
+			unlink(_destination.c_str());
+			return UNIX_FILE_OPEN_ERR - err;
+		}
+
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+		const auto cloned = ioctl(destination, FICLONE, source);
+		const auto err = errno;
+
+		close(source);
+
+		if (cloned < 0) {
+			close(destination);
+			unlink(_destination.c_str());
+			return is_clone_unsupported(err) ? SYS_NOT_SUPPORTED : UNIX_FILE_WRITE_ERR - err;
+		}
+
+		// The snapshot is only useful if it survives a crash right after the truncate.
+		if (fsync(destination) < 0 || close(destination) < 0) {
+			const auto err = errno;
+			unlink(_destination.c_str());
+			return UNIX_FILE_WRITE_ERR - err;
+		}
+
+		return 0;
+#else
+		return SYS_NOT_SUPPORTED;
+#endif
+	} // clone_file
+
+	// Registering the snapshot keeps it from being forgotten on the storage once the client has lost the output.
+	auto register_snapshot(RsComm& _comm,
+	                       const std::string& _logical_path,
+	                       const std::string& _physical_path,
+	                       std::string_view _hierarchy,
+	                       rodsLong_t _size) -> int
+	{
+		// Registering a file inside of a vault requires rodsadmin privileges, which the client usually lacks. The
+		// registration below runs with the privileges of the server, so the client's permission to create the
+		// snapshot next to the original is checked here instead. The snapshot is still owned by the client.
+		auto collection = _logical_path.substr(0, _logical_path.rfind('/'));
+		auto permission = std::string{ACCESS_MODIFY_OBJECT};
+
+		if (const auto ec = checkCollAccessPerm(&_comm, collection.data(), permission.data()); ec < 0) {
+			return ec;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		copy_into(input.objPath, _logical_path);
+		input.dataSize = _size;
+
+		auto cond_input = irods::experimental::make_key_value_proxy(input.condInput);
+		cond_input[FILE_PATH_KW] = _physical_path;
+		cond_input[RESC_HIER_STR_KW] = _hierarchy;
+		cond_input[DEST_RESC_NAME_KW] = irods::replica_truncate::root_of(_hierarchy);
+		cond_input[DATA_SIZE_KW] = std::to_string(_size);
+
+		irods::experimental::scoped_privileged_client privileged{_comm};
+
+		return rsPhyPathReg(&_comm, &input);
+	} // register_snapshot
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto to_snapshot_mode(std::string_view _mode) -> std::optional<snapshot_mode>
+	{
+		if ("clone" == _mode) {
+			return snapshot_mode::clone;
+		}
+
+		if ("clone_or_copy" == _mode) {
+			return snapshot_mode::clone_or_copy;
+		}
+
+		return std::nullopt;
+	} // to_snapshot_mode
+
+	auto snapshot_physical_data(RsComm& _comm,
+	                            std::string_view _logical_path,
+	                            std::string_view _physical_path,
+	                            std::string_view _hierarchy,
+	                            rodsLong_t _size,
+	                            snapshot_mode _mode,
+	                            data_snapshot& _snapshot) -> int
+	{
+		// The snapshot lives next to the original, since a clone cannot cross file systems. It is registered next to
+		// the original as well, under the same suffix.
+		const auto now = std::chrono::system_clock::now().time_since_epoch();
+		const auto suffix =
+			fmt::format(".snapshot.{}", std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+		auto path = fmt::format("{}{}", _physical_path, suffix);
+		auto logical_path = fmt::format("{}{}", _logical_path, suffix);
+
+		if (path.size() >= MAX_NAME_LEN || logical_path.size() >= MAX_NAME_LEN) {
+			return USER_STRLEN_TOOLONG;
+		}
+
+		// Cloning needs the file itself, which only this server's file system can give us.
+		const auto clone_ec = is_local_unixfilesystem(_hierarchy) ? clone_file(std::string{_physical_path}, path)
+		                                                          : SYS_NOT_SUPPORTED;
+		const char* method = "clone";
+
+		if (0 != clone_ec) {
+			if (SYS_NOT_SUPPORTED != clone_ec || snapshot_mode::clone == _mode) {
+				return clone_ec;
+			}
+
+			logging::debug(logging::category::request,
+			               "{}: Cannot clone [{}] in [{}]. Copying it instead.",
+			               __func__,
+			               _physical_path,
+			               _hierarchy);
+
+			if (const auto ec = copy_physical_data(_comm, _logical_path, _physical_path, _hierarchy, path, _size);
+			    ec < 0)
+			{
+				return ec;
+			}
+
+			method = "copy";
+		}
+
+		if (const auto ec = register_snapshot(_comm, logical_path, path, _hierarchy, _size); ec < 0) {
+			logging::warn(logging::category::request,
+			              "{}: Could not register snapshot [{}] as [{}]. Removing it. [ec={}]",
+			              __func__,
+			              path,
+			              logical_path,
+			              ec);
+			unlink_physical_data(_comm, _logical_path, _hierarchy, path);
+			return ec;
+		}
+
+		_snapshot = {.logical_path = std::move(logical_path), .physical_path = std::move(path), .method = method};
+		return 0;
+	} // snapshot_physical_data
+
+	auto remove_snapshot(RsComm& _comm, const data_snapshot& _snapshot) -> int
+	{
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		copy_into(input.objPath, _snapshot.logical_path);
+
+		// The snapshot was never meant to be kept by itself, so it does not go to the trash.
+		addKeyVal(&input.condInput, FORCE_FLAG_KW, "");
+
+		return rsDataObjUnlink(&_comm, &input);
+	} // remove_snapshot
+} // namespace irods::replica_truncate
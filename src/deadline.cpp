@@ -0,0 +1,70 @@
+#include "irods/plugins/api/private/deadline.hpp"
+
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/irods_exception.hpp>
+#include <irods/objInfo.h>
+#include <irods/rcMisc.h>
+#include <irods/rodsErrorTable.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto deadline::from_input(const DataObjInp& _input) -> deadline
+	{
+		deadline d;
+
+		const auto* value = getValByKey(&_input.condInput, TRUNCATE_DEADLINE_KW);
+		if (!value) {
+			return d;
+		}
+
+		try {
+			d.at_ = clock_type::time_point{std::chrono::milliseconds{std::stoll(value)}};
+		}
+		catch (const std::exception&) {
+			THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Invalid value for [{}]: [{}]", TRUNCATE_DEADLINE_KW, value));
+		}
+
+		return d;
+	} // deadline::from_input
+
+	auto deadline::expired() const -> bool
+	{
+		return at_ && clock_type::now() >= *at_;
+	} // deadline::expired
+
+	auto deadline::cap(std::chrono::milliseconds _timeout) const -> std::chrono::milliseconds
+	{
+		if (!at_) {
+			return _timeout;
+		}
+
+		const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*at_ - clock_type::now());
+		return std::clamp(remaining, std::chrono::milliseconds{0}, _timeout);
+	} // deadline::cap
+
+	auto deadline::fail(nlohmann::json& _output, const char* _logical_path, const char* _phase) const -> int
+	{
+		logging::debug(logging::category::deadline,
+		               "Abandoning truncate of [{}] before {}: deadline exceeded.",
+		               _logical_path,
+		               _phase);
+
+		_output["message"] =
+			fmt::format("Cannot truncate object [{}]: Deadline exceeded before {}.", _logical_path, _phase);
+		_output["deadline_exceeded"] = true;
+
+		return error_code;
+	} // deadline::fail
+} // namespace irods::replica_truncate
@@ -0,0 +1,88 @@
+#include "irods/plugins/api/private/deferred_notifications.hpp"
+
+#include "irods/plugins/api/private/logging.hpp"
+
+#include <irods/dataObjInpOut.h>
+#include <irods/fileDriver.hpp>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/irods_file_object.hpp>
+#include <irods/rcMisc.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rodsKeyWdDef.h>
+
+#include <boost/make_shared.hpp> // Needed for irods::file_object_ptr, which is a boost::shared_ptr...
+
+#include <string>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto notify_modified(RsComm& _comm, DataObjInfo& _replica) -> int
+	{
+		// Resources such as replication and compound only act on fileModified for writes, which they recognize by
+		// OPEN_TYPE_KW. The file object takes its cond_input from the replica.
+		addKeyVal(&_replica.condInput, OPEN_TYPE_KW, std::to_string(OPEN_FOR_WRITE_TYPE).c_str());
+		irods::at_scope_exit clear_cond_input{[&_replica] { clearKeyVal(&_replica.condInput); }};
+
+		irods::file_object_ptr file_obj = boost::make_shared<irods::file_object>(&_comm, &_replica);
+
+		if (const auto ret = fileModified(&_comm, file_obj); !ret.ok()) {
+			logging::error(logging::category::request,
+			               "{}: fileModified failed for [{}] in [{}]. [{}]",
+			               __func__,
+			               _replica.objPath,
+			               _replica.rescHier,
+			               ret.result());
+			return static_cast<int>(ret.code());
+		}
+
+		return 0;
+	} // notify_modified
+
+	auto deferred_notifications::add(const DataObjInfo& _replica) -> void
+	{
+		if (!seen_.emplace(_replica.objPath, _replica.rescHier).second) {
+			return;
+		}
+
+		// The copy must not share anything the caller frees.
+		DataObjInfo copy = _replica;
+		copy.next = nullptr;
+		copy.specColl = nullptr;
+		copy.condInput = {};
+
+		pending_.push_back(copy);
+	} // add
+
+	auto deferred_notifications::deliver(RsComm& _comm) -> int
+	{
+		int first_error{};
+
+		for (auto& replica : pending_) {
+			if (const auto ec = notify_modified(_comm, replica); ec < 0) {
+				++failed_;
+
+				if (0 == first_error) {
+					first_error = ec;
+				}
+
+				continue;
+			}
+
+			++delivered_;
+		}
+
+		pending_.clear();
+
+		return first_error;
+	} // deliver
+
+	auto deferred_notifications::summary() const -> nlohmann::json
+	{
+		return {{"deferred", seen_.size()}, {"delivered", delivered_}, {"failed", failed_}};
+	} // summary
+} // namespace irods::replica_truncate
@@ -0,0 +1,427 @@
+#include "irods/plugins/api/private/idempotent_request.hpp"
+
+#include "irods/plugins/api/private/configuration.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/shared_memory.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/irods_exception.hpp>
+#include <irods/objInfo.h>
+#include <irods/rcConnect.h>
+#include <irods/rcMisc.h>
+#include <irods/rodsDef.h>
+#include <irods/rodsErrorTable.h>
+
+#include <fmt/format.h>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	namespace shm = irods::replica_truncate::shared_memory;
+
+	constexpr const char* table_name = "idempotency_table";
+
+	// Bounds the number of requests remembered at once. When the table is full, the result which expires soonest is
+	// forgotten first.
+	constexpr std::size_t slot_count = 512;
+
+	constexpr std::size_t max_request_id_size = 64;
+
+	// Results larger than this are reduced to their top-level values before they are stored.
+	constexpr std::size_t max_output_size = 3 * 1024;
+
+	constexpr auto lock_timeout = std::chrono::seconds{5};
+
+	// How long a retry waits for the original request to finish. Also how often it checks that the agent running
+	// the original request is still alive.
+	constexpr auto wait_timeout = std::chrono::minutes{5};
+	constexpr auto poll_interval = std::chrono::seconds{1};
+
+	// Lives in shared memory, so it must only contain trivially copyable data.
+	struct request_slot
+	{
+		bool in_use{};
+		std::array<char, 2 * NAME_LEN + max_request_id_size + 2> key{};
+
+		// Detects a request ID which is reused for a different request.
+		std::size_t fingerprint{};
+
+		// The agent running the request. Zero once the result has been stored.
+		pid_t owner_pid{};
+
+		// Distinguishes the claims of a slot which is reused, so that an agent never overwrites a claim which is not
+		// its own.
+		std::uint64_t generation{};
+
+		// Seconds since the Unix epoch. Only meaningful once the result has been stored.
+		std::int64_t expires_at{};
+
+		int ec{};
+		std::size_t output_size{};
+		std::array<char, max_output_size> output{};
+	}; // struct request_slot
+
+	struct idempotency_table
+	{
+		shm::mutex_type mutex;
+		shm::condition_type changed;
+		std::uint64_t next_generation{};
+		std::array<request_slot, slot_count> slots{};
+	}; // struct idempotency_table
+
+	auto table() -> idempotency_table&
+	{
+		static auto& table = shm::find_or_construct<idempotency_table>(table_name);
+		return table;
+	} // table
+
+	auto now_seconds() -> std::int64_t
+	{
+		// Wall clock time, because results outlive the agents which stored them.
+		return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+		    .count();
+	} // now_seconds
+
+	auto ttl_seconds() -> std::int64_t
+	{
+		const auto& config = irods::replica_truncate::plugin_configuration();
+
+		const auto section = config.find("idempotency");
+		if (section == config.end() || !section->is_object()) {
+			return 900;
+		}
+
+		return std::max<std::int64_t>(0, section->value("ttl_in_seconds", std::int64_t{900}));
+	} // ttl_seconds
+
+	auto is_expired(const request_slot& _slot, std::int64_t _now) -> bool
+	{
+		return 0 == _slot.owner_pid && _slot.expires_at <= _now;
+	} // is_expired
+
+	// Everything which determines what the request does. The deadline changes with every retry, so it is left out.
+	auto fingerprint_of(const DataObjInp& _input) -> std::size_t
+	{
+		std::vector<std::pair<std::string_view, std::string_view>> keywords;
+		keywords.reserve(static_cast<std::size_t>(std::max(0, _input.condInput.len)));
+
+		for (int i = 0; i < _input.condInput.len; ++i) {
+			const std::string_view keyword = _input.condInput.keyWord[i];
+
+			if (TRUNCATE_DEADLINE_KW != keyword && TRUNCATE_REQUEST_ID_KW != keyword) {
+				keywords.emplace_back(keyword, _input.condInput.value[i] ? _input.condInput.value[i] : "");
+			}
+		}
+
+		std::sort(std::begin(keywords), std::end(keywords));
+
+		auto s = fmt::format("{}\n{}\n", _input.objPath, _input.dataSize);
+		for (const auto& [k, v] : keywords) {
+			fmt::format_to(std::back_inserter(s), "{}={}\n", k, v);
+		}
+
+		return std::hash<std::string>{}(s);
+	} // fingerprint_of
+
+	auto find_slot(idempotency_table& _table, std::string_view _key, std::int64_t _now) -> request_slot*
+	{
+		const auto itr = std::find_if(std::begin(_table.slots), std::end(_table.slots), [&](const auto& _s) {
+			return _s.in_use && !is_expired(_s, _now) && _key == _s.key.data();
+		});
+
+		return itr == std::end(_table.slots) ? nullptr : &*itr;
+	} // find_slot
+
+	auto allocate_slot(idempotency_table& _table, std::int64_t _now) -> request_slot*
+	{
+		// Slots of requests whose agent died, or whose result expired, are reclaimed here.
+		auto itr = std::find_if(std::begin(_table.slots), std::end(_table.slots), [_now](const auto& _s) {
+			return !_s.in_use || is_expired(_s, _now) || (0 != _s.owner_pid && !shm::process_exists(_s.owner_pid));
+		});
+
+		if (itr == std::end(_table.slots)) {
+			// Forget the stored result which would have expired first. Requests which are still running are kept.
+			request_slot* oldest{};
+
+			for (auto& s : _table.slots) {
+				if (0 == s.owner_pid && (!oldest || s.expires_at < oldest->expires_at)) {
+					oldest = &s;
+				}
+			}
+
+			return oldest;
+		}
+
+		return &*itr;
+	} // allocate_slot
+
+	// Keeps the top-level values of a result which is too large to store whole, e.g. a collection's list of failures.
+	auto reduce(const nlohmann::json& _output) -> std::string
+	{
+		auto reduced = nlohmann::json::object();
+
+		for (const auto& [k, v] : _output.items()) {
+			if (!v.is_structured() || "summary" == k) {
+				reduced[k] = v;
+			}
+		}
+
+		reduced["output_reduced"] = true;
+
+		return reduced.dump();
+	} // reduce
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	idempotent_request::idempotent_request(const RsComm& _comm, const DataObjInp& _input, const deadline& _deadline)
+	{
+		const auto* request_id = getValByKey(&_input.condInput, TRUNCATE_REQUEST_ID_KW);
+		if (!request_id) {
+			return;
+		}
+
+		const std::string_view id = request_id;
+		if (id.empty() || id.size() > max_request_id_size) {
+			THROW(SYS_INVALID_INPUT_PARAM,
+			      fmt::format("Invalid value for [{}]: Must be 1 to {} characters long.",
+			                  TRUNCATE_REQUEST_ID_KW,
+			                  max_request_id_size));
+		}
+
+		// The server which received the request from the client remembers it. The server it was handed off to does
+		// not need to.
+		if (getValByKey(&_input.condInput, TRUNCATE_REDIRECTED_KW)) {
+			return;
+		}
+
+		ttl_seconds_ = ttl_seconds();
+		if (0 == ttl_seconds_) {
+			return;
+		}
+
+		// The user is part of the key so that one user never receives the result of another user's request.
+		const auto key = fmt::format("{}#{}:{}", _comm.clientUser.userName, _comm.clientUser.rodsZone, id);
+		const auto fingerprint = fingerprint_of(_input);
+
+		idempotency_table* t{};
+
+		try {
+			t = &table();
+		}
+		catch (const boost::interprocess::interprocess_exception& e) {
+			logging::warn(logging::category::idempotency,
+			              "{}: Could not open shared memory. Request [{}] will not be remembered. [{}]",
+			              __func__,
+			              id,
+			              e.what());
+			return;
+		}
+
+		auto lock = shm::lock_for(t->mutex, lock_timeout);
+		if (!lock) {
+			logging::warn(logging::category::idempotency,
+			              "{}: Timed out waiting for idempotency table lock. Request [{}] will not be remembered.",
+			              __func__,
+			              id);
+			return;
+		}
+
+		const auto give_up_at = std::chrono::steady_clock::now() +
+		                        _deadline.cap(std::chrono::duration_cast<std::chrono::milliseconds>(wait_timeout));
+
+		while (true) {
+			auto* slot = find_slot(*t, key, now_seconds());
+
+			if (!slot) {
+				slot = allocate_slot(*t, now_seconds());
+
+				if (!slot) {
+					logging::warn(logging::category::idempotency,
+					              "{}: Idempotency table is full. Request [{}] will not be remembered.",
+					              __func__,
+					              id);
+					return;
+				}
+
+				*slot = request_slot{};
+				slot->in_use = true;
+				std::memcpy(slot->key.data(), key.data(), key.size());
+				slot->fingerprint = fingerprint;
+				slot->owner_pid = getpid();
+				slot->generation = ++t->next_generation;
+
+				slot_index_ = static_cast<std::size_t>(slot - t->slots.data());
+				generation_ = slot->generation;
+				state_ = state::claimed;
+
+				return;
+			}
+
+			if (slot->fingerprint != fingerprint) {
+				THROW(SYS_INVALID_INPUT_PARAM,
+				      fmt::format("Request ID [{}] was already used for a different request.", id));
+			}
+
+			if (0 == slot->owner_pid) {
+				replay_ec_ = slot->ec;
+				replay_output_ = nlohmann::json::parse(std::string_view{slot->output.data(), slot->output_size});
+				replay_output_["replayed"] = true;
+				state_ = state::replay;
+
+				logging::debug(
+					logging::category::idempotency, "{}: Replaying result of request [{}].", __func__, id);
+
+				return;
+			}
+
+			if (!shm::process_exists(slot->owner_pid)) {
+				// Whether the request took effect is unknown, so it runs again. This is what would happen without a
+				// request ID, and a truncate to the same size is harmless.
+				logging::warn(logging::category::idempotency,
+				              "{}: Agent [{}] running request [{}] exited without storing a result. Running it again.",
+				              __func__,
+				              slot->owner_pid,
+				              id);
+
+				slot->owner_pid = getpid();
+				slot->generation = ++t->next_generation;
+
+				slot_index_ = static_cast<std::size_t>(slot - t->slots.data());
+				generation_ = slot->generation;
+				state_ = state::claimed;
+
+				return;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			if (now >= give_up_at) {
+				if (_deadline.expired()) {
+					replay_ec_ = _deadline.fail(replay_output_, _input.objPath, "the earlier attempt finished");
+				}
+				else {
+					replay_output_["message"] = fmt::format(
+						"Cannot truncate object [{}]: An earlier attempt of request [{}] is still in progress.",
+						_input.objPath,
+						id);
+					replay_ec_ = LOCKED_DATA_OBJECT_ACCESS;
+				}
+
+				state_ = state::replay;
+
+				return;
+			}
+
+			const auto wait_for = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::min<std::chrono::steady_clock::duration>(poll_interval, give_up_at - now));
+			t->changed.timed_wait(lock,
+			                      boost::posix_time::microsec_clock::universal_time() +
+			                          boost::posix_time::milliseconds(wait_for.count()));
+		}
+	} // idempotent_request
+
+	idempotent_request::~idempotent_request()
+	{
+		if (state::claimed == state_) {
+			try {
+				release();
+			}
+			catch (...) {
+			}
+		}
+	} // ~idempotent_request
+
+	auto idempotent_request::replay(nlohmann::json& _output) const -> std::optional<int>
+	{
+		if (state::replay != state_) {
+			return std::nullopt;
+		}
+
+		_output = replay_output_;
+
+		return replay_ec_;
+	} // replay
+
+	auto idempotent_request::record(int _ec, const nlohmann::json& _output) -> void
+	{
+		if (state::claimed != state_) {
+			return;
+		}
+
+		// A failure before the data was truncated changed nothing, so a retry may run again. One after it is kept,
+		// so that a retry reports what happened to the data instead of truncating it (and snapshotting it) again.
+		if (_ec < 0 && !_output.value("data_truncated", false)) {
+			release();
+			return;
+		}
+
+		auto serialized = _output.dump();
+		if (serialized.size() > max_output_size) {
+			serialized = reduce(_output);
+		}
+
+		if (serialized.size() > max_output_size) {
+			serialized = nlohmann::json{{"message", ""}, {"output_reduced", true}}.dump();
+		}
+
+		state_ = state::unrecorded;
+
+		auto& t = table();
+		auto lock = shm::lock_for(t.mutex, lock_timeout);
+		if (!lock) {
+			// Retries will notice that this agent is gone once it exits, and run again.
+			logging::warn(logging::category::idempotency,
+			              "{}: Timed out waiting for idempotency table lock. Result not stored.",
+			              __func__);
+			return;
+		}
+
+		auto& slot = t.slots.at(slot_index_);
+		if (slot.generation != generation_) {
+			return;
+		}
+
+		slot.owner_pid = 0;
+		slot.expires_at = now_seconds() + ttl_seconds_;
+		slot.ec = _ec;
+		slot.output_size = serialized.size();
+		std::memcpy(slot.output.data(), serialized.data(), serialized.size());
+
+		t.changed.notify_all();
+	} // record
+
+	auto idempotent_request::release() -> void
+	{
+		state_ = state::unrecorded;
+
+		auto& t = table();
+		auto lock = shm::lock_for(t.mutex, lock_timeout);
+
+		// If the lock cannot be acquired, the slot is reclaimed once this agent exits.
+		if (!lock) {
+			return;
+		}
+
+		if (auto& slot = t.slots.at(slot_index_); slot.generation == generation_) {
+			slot = request_slot{};
+		}
+
+		t.changed.notify_all();
+	} // release
+} // namespace irods::replica_truncate
@@ -0,0 +1,358 @@
+#include "irods/plugins/api/private/logging.hpp"
+
+#include "irods/plugins/api/private/configuration.hpp"
+
+#include <irods/irods_logger.hpp>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+namespace
+{
+	using log_api = irods::experimental::log::api;
+	using irods::replica_truncate::logging::category;
+	using irods::replica_truncate::logging::level;
+
+	// clang-format off
+	constexpr std::array<std::string_view, 9> category_names{
+		"request",
+		"selection",
+		"redirect",
+		"coalescing",
+		"admission",
+		"collection",
+		"deadline",
+		"usage",
+		"idempotency"
+	};
+	// clang-format on
+
+	struct category_settings
+	{
+		level min_level = level::warn;
+
+		// Write one in every sample_every messages below warn.
+		std::uint64_t sample_every = 1;
+
+		// Zero means unlimited.
+		double max_per_second = 10;
+	}; // struct category_settings
+
+	struct category_state
+	{
+		category_settings settings;
+
+		std::mutex mutex;
+		std::uint64_t sampled{};
+		double tokens{};
+		std::chrono::steady_clock::time_point last_refill = std::chrono::steady_clock::now();
+		std::uint64_t suppressed{};
+	}; // struct category_state
+
+	struct record
+	{
+		category which;
+		level severity;
+		std::string message;
+	}; // struct record
+
+	auto to_level(std::string_view _value, level _default) -> level
+	{
+		// clang-format off
+		if ("trace" == _value) { return level::trace; }
+		if ("debug" == _value) { return level::debug; }
+		if ("info" == _value)  { return level::info; }
+		if ("warn" == _value)  { return level::warn; }
+		if ("error" == _value) { return level::error; }
+		// clang-format on
+
+		return _default;
+	} // to_level
+
+	auto read_settings(const nlohmann::json& _section, category_settings _defaults) -> category_settings
+	{
+		if (const auto l = _section.find("level"); l != _section.end() && l->is_string()) {
+			_defaults.min_level = to_level(l->get_ref<const std::string&>(), _defaults.min_level);
+		}
+
+		_defaults.sample_every = std::max<std::uint64_t>(1, _section.value("sample_every", _defaults.sample_every));
+		_defaults.max_per_second = std::max(0.0, _section.value("max_per_second", _defaults.max_per_second));
+
+		return _defaults;
+	} // read_settings
+
+	auto logging_section() -> const nlohmann::json&
+	{
+		static const auto empty = nlohmann::json::object();
+
+		const auto& config = irods::replica_truncate::plugin_configuration();
+		const auto section = config.find("logging");
+
+		return section != config.end() && section->is_object() ? *section : empty;
+	} // logging_section
+
+	auto load_states(std::array<category_state, category_names.size()>& _states) -> void
+	{
+		const auto& section = logging_section();
+		const auto defaults = read_settings(section, {});
+		const auto categories = section.find("categories");
+
+		for (std::size_t i = 0; i < category_names.size(); ++i) {
+			auto& s = _states.at(i);
+			s.settings = defaults;
+
+			if (categories != section.end()) {
+				if (const auto c = categories->find(category_names.at(i)); c != categories->end()) {
+					s.settings = read_settings(*c, defaults);
+				}
+			}
+
+			// Start with a full bucket so that the first messages of an agent are never suppressed.
+			s.tokens = std::max(1.0, s.settings.max_per_second);
+		}
+	} // load_states
+
+	auto states() -> std::array<category_state, category_names.size()>&
+	{
+		static std::array<category_state, category_names.size()> states;
+		static const bool loaded = (load_states(states), true);
+		static_cast<void>(loaded);
+
+		return states;
+	} // states
+
+	auto state_of(category _category) -> category_state&
+	{
+		return states().at(static_cast<std::size_t>(_category));
+	} // state_of
+
+	auto emit(category _category, level _level, std::string_view _message) -> void
+	{
+		const auto name = category_names.at(static_cast<std::size_t>(_category));
+
+		// clang-format off
+		switch (_level) {
+			case level::trace: log_api::trace("[replica_truncate.{}] {}", name, _message); break;
+			case level::debug: log_api::debug("[replica_truncate.{}] {}", name, _message); break;
+			case level::info:  log_api::info("[replica_truncate.{}] {}", name, _message);  break;
+			case level::warn:  log_api::warn("[replica_truncate.{}] {}", name, _message);  break;
+			case level::error: log_api::error("[replica_truncate.{}] {}", name, _message); break;
+		}
+		// clang-format on
+	} // emit
+
+	// Writes queued messages to the server log from a background thread. The thread is started by the first message,
+	// so agents which never log do not pay for it.
+	//
+	// The sink is never destroyed and its thread is detached, since a forked child has no thread to join. When the
+	// agent exits, the messages still queued are written by the exiting thread, after the worker has finished the
+	// batch it is writing. The worker then stops for good, since the logger may already be gone when it next runs.
+	class async_sink
+	{
+	  public:
+		async_sink()
+			: capacity_{std::max<std::size_t>(1, logging_section().value("queue_size", std::size_t{1024}))}
+		{
+			// A fork while the worker holds a mutex would leave it locked forever in the child.
+			pthread_atfork(
+				[] {
+					instance()->mutex_.lock();
+					instance()->write_mutex_.lock();
+				},
+				[] {
+					instance()->write_mutex_.unlock();
+					instance()->mutex_.unlock();
+				},
+				[] {
+					instance()->write_mutex_.unlock();
+					instance()->mutex_.unlock();
+				});
+
+			// Registered after the logger was constructed, so this runs before the logger is destroyed.
+			std::atexit([] { instance()->flush_at_exit(); });
+		}
+
+		async_sink(const async_sink&) = delete;
+		auto operator=(const async_sink&) -> async_sink& = delete;
+
+		~async_sink() = default;
+
+		static auto instance() -> async_sink*
+		{
+			static auto* sink = new async_sink;
+			return sink;
+		} // instance
+
+		auto push(record _record) -> void
+		{
+			{
+				std::lock_guard lock{mutex_};
+
+				// Threads do not survive a fork, so a child starts its own worker for the queue it inherited.
+				if (getpid() != worker_pid_) {
+					try {
+						std::thread{[this] { run(); }}.detach();
+						worker_pid_ = getpid();
+					}
+					catch (const std::system_error&) {
+						++dropped_;
+						return;
+					}
+				}
+
+				if (queue_.size() >= capacity_) {
+					++dropped_;
+					return;
+				}
+
+				queue_.push_back(std::move(_record));
+			}
+
+			not_empty_.notify_one();
+		} // push
+
+	  private:
+		static auto write(const std::deque<record>& _batch, std::uint64_t _dropped) -> void
+		{
+			if (_dropped > 0) {
+				log_api::warn("[replica_truncate] Log queue full. Dropped [{}] messages.", _dropped);
+			}
+
+			for (const auto& r : _batch) {
+				emit(r.which, r.severity, r.message);
+			}
+		} // write
+
+		auto run() -> void
+		{
+			std::unique_lock lock{mutex_};
+
+			while (true) {
+				// A wakeup can be lost in a forked child, whose condition variable may still count the parent's
+				// worker as a waiter, so the queue is also checked periodically.
+				const auto ready = not_empty_.wait_for(
+					lock, std::chrono::seconds{1}, [this] { return exiting_ || !queue_.empty(); });
+
+				if (exiting_) {
+					return;
+				}
+
+				if (!ready) {
+					continue;
+				}
+
+				auto batch = std::exchange(queue_, {});
+				const auto dropped = std::exchange(dropped_, 0);
+
+				// Taken before the queue is released, so that flush_at_exit cannot get ahead of this batch.
+				std::unique_lock writing{write_mutex_};
+				lock.unlock();
+
+				write(batch, dropped);
+
+				writing.unlock();
+				lock.lock();
+			}
+		} // run
+
+		auto flush_at_exit() -> void
+		{
+			// Waits for the batch the worker is writing, so that messages are neither lost nor written out of order.
+			std::lock_guard lock{mutex_};
+			std::lock_guard writing{write_mutex_};
+
+			exiting_ = true;
+			write(std::exchange(queue_, {}), std::exchange(dropped_, 0));
+		} // flush_at_exit
+
+		const std::size_t capacity_;
+
+		// Guards the queue and exiting_. When both are needed, it is locked before write_mutex_.
+		std::mutex mutex_;
+
+		// Held while a batch is being written to the server log.
+		std::mutex write_mutex_;
+
+		bool exiting_{};
+		std::condition_variable not_empty_;
+		std::deque<record> queue_;
+		std::uint64_t dropped_{};
+
+		// The process which the worker thread belongs to. Zero until the first message.
+		pid_t worker_pid_{};
+	}; // class async_sink
+
+	auto sink() -> async_sink&
+	{
+		return *async_sink::instance();
+	} // sink
+} // anonymous namespace
+
+namespace irods::replica_truncate::logging
+{
+	auto should_write(category _category, level _level) -> bool
+	{
+		auto& state = state_of(_category);
+
+		// Checked without the lock. The settings never change after they are read.
+		if (_level < state.settings.min_level) {
+			return false;
+		}
+
+		std::lock_guard lock{state.mutex};
+
+		if (_level < level::warn && 0 != state.sampled++ % state.settings.sample_every) {
+			return false;
+		}
+
+		const auto max_per_second = state.settings.max_per_second;
+		if (max_per_second <= 0) {
+			return true;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		const auto elapsed = std::chrono::duration<double>(now - state.last_refill).count();
+		state.tokens = std::min(std::max(1.0, max_per_second), state.tokens + elapsed * max_per_second);
+		state.last_refill = now;
+
+		if (state.tokens < 1.0) {
+			++state.suppressed;
+			return false;
+		}
+
+		state.tokens -= 1.0;
+
+		return true;
+	} // should_write
+
+	auto submit(category _category, level _level, std::string _message) -> void
+	{
+		auto& state = state_of(_category);
+
+		std::uint64_t suppressed{};
+		{
+			std::lock_guard lock{state.mutex};
+			suppressed = std::exchange(state.suppressed, 0);
+		}
+
+		if (suppressed > 0) {
+			_message += fmt::format(" [{} earlier messages suppressed]", suppressed);
+		}
+
+		sink().push({_category, _level, std::move(_message)});
+	} // submit
+} // namespace irods::replica_truncate::logging
@@ -0,0 +1,86 @@
+#include "irods/plugins/api/private/output.hpp"
+
+#include "irods/plugins/api/private/logging.hpp"
+
+#include <irods/rodsDef.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+
+	// Large enough for the output of a single replica truncate, including a long error message. Collection summaries
+	// may spill over into the heap. Agents handle one request at a time, so every request reuses the same buffer.
+	constexpr std::size_t buffer_size = 16 * 1024;
+
+	alignas(std::max_align_t) std::array<std::byte, buffer_size> buffer{};
+
+	// Lets nlohmann::json serialize straight into a string allocated from the buffer.
+	class string_appender : public std::streambuf
+	{
+	  public:
+		explicit string_appender(std::pmr::string& _s)
+			: s_{_s}
+		{
+		}
+
+	  protected:
+		auto overflow(int_type _c) -> int_type override
+		{
+			if (!traits_type::eq_int_type(_c, traits_type::eof())) {
+				s_.push_back(traits_type::to_char_type(_c));
+			}
+
+			return traits_type::not_eof(_c);
+		} // overflow
+
+		auto xsputn(const char_type* _s, std::streamsize _n) -> std::streamsize override
+		{
+			s_.append(_s, static_cast<std::size_t>(_n));
+			return _n;
+		} // xsputn
+
+	  private:
+		std::pmr::string& s_;
+	}; // class string_appender
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto make_output_struct(nlohmann::json _output) -> BytesBuf*
+	{
+		if (!_output.contains("message")) {
+			_output["message"] = "";
+		}
+
+		std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size(), std::pmr::new_delete_resource()};
+
+		std::pmr::string json_str{&resource};
+		json_str.reserve(512);
+
+		{
+			string_appender appender{json_str};
+			std::ostream os{&appender};
+			os << _output;
+		}
+
+		logging::debug(logging::category::request, "json: [{}]", std::string_view{json_str});
+
+		// The framework frees the buffer and the struct separately, so these cannot come from the buffer.
+		auto* output = static_cast<BytesBuf*>(std::malloc(sizeof(BytesBuf)));
+		output->len = static_cast<int>(json_str.size() + 1);
+		output->buf = std::malloc(json_str.size() + 1);
+		std::memcpy(output->buf, json_str.c_str(), json_str.size() + 1);
+
+		return output;
+	} // make_output_struct
+} // namespace irods::replica_truncate
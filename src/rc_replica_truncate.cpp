@@ -7,7 +7,7 @@
 
 auto rc_replica_truncate(RcComm* _comm, DataObjInp* _input, BytesBuf** _output) -> int
 {
-	if (!_message || !_response) {
+	if (!_input || !_output) {
 		return USER__NULL_INPUT_ERR;
 	}
 
@@ -0,0 +1,169 @@
+#include "irods/plugins/api/private/record_boundary.hpp"
+
+#include "irods/plugins/api/private/configuration.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/fileClose.h>
+#include <irods/fileLseek.h>
+#include <irods/fileOpen.h>
+#include <irods/fileRead.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/rodsDef.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rsFileClose.hpp>
+#include <irods/rsFileLseek.hpp>
+#include <irods/rsFileOpen.hpp>
+#include <irods/rsFileRead.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::copy_into;
+
+	// Records are usually much shorter than this, so most searches read a single chunk.
+	constexpr rodsLong_t chunk_size = 64 * 1024;
+
+	constexpr rodsLong_t default_max_scan_size = 64 * 1024 * 1024;
+
+	auto get_max_scan_size() -> rodsLong_t
+	{
+		const auto& config = irods::replica_truncate::plugin_configuration();
+
+		const auto section = config.find("record_boundary");
+		if (section == config.end()) {
+			return default_max_scan_size;
+		}
+
+		return std::max<rodsLong_t>(section->value("max_scan_in_bytes", default_max_scan_size), chunk_size);
+	} // get_max_scan_size
+
+	// Read exactly _length bytes at _offset, unless the data ends first.
+	auto read_at(RsComm& _comm, int _fd, rodsLong_t _offset, char* _buffer, int _length) -> int
+	{
+		fileLseekInp_t seek_input{};
+		seek_input.fileInx = _fd;
+		seek_input.offset = _offset;
+		seek_input.whence = SEEK_SET;
+
+		fileLseekOut_t* seek_output{};
+		const auto ec = rsFileLseek(&_comm, &seek_input, &seek_output);
+		std::free(seek_output); // NOLINT(cppcoreguidelines-no-malloc)
+
+		if (ec < 0) {
+			return ec;
+		}
+
+		int total = 0;
+
+		while (total < _length) {
+			fileReadInp_t inp{};
+			inp.fileInx = _fd;
+			inp.len = _length - total;
+
+			BytesBuf buf{};
+			buf.buf = _buffer + total;
+			buf.len = _length - total;
+
+			const auto read = rsFileRead(&_comm, &inp, &buf);
+			if (read < 0) {
+				return read;
+			}
+
+			if (0 == read) {
+				break;
+			}
+
+			total += read;
+		}
+
+		return total;
+	} // read_at
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto find_record_boundary(RsComm& _comm,
+	                          std::string_view _logical_path,
+	                          std::string_view _physical_path,
+	                          std::string_view _hierarchy,
+	                          char _delimiter,
+	                          rodsLong_t _max_size,
+	                          rodsLong_t _data_size,
+	                          rodsLong_t& _boundary) -> int
+	{
+		// Bytes beyond the end of the data would be zeros after a truncate, so they never hold a delimiter.
+		const auto start = std::min(_max_size, _data_size);
+		if (start <= 0) {
+			_boundary = 0;
+			return 0;
+		}
+
+		std::string host;
+		if (const auto ec = host_of_hierarchy(_hierarchy, host); ec < 0) {
+			return ec;
+		}
+
+		fileOpenInp_t open_input{};
+		copy_into(open_input.fileName, _physical_path);
+		copy_into(open_input.resc_hier_, _hierarchy);
+		copy_into(open_input.objPath, _logical_path);
+		copy_into(open_input.addr.hostAddr, host);
+		open_input.flags = O_RDONLY;
+
+		const auto fd = rsFileOpen(&_comm, &open_input);
+		if (fd < 0) {
+			return fd;
+		}
+
+		irods::at_scope_exit close_file{[&_comm, fd] {
+			fileCloseInp_t close_input{};
+			close_input.fileInx = fd;
+			rsFileClose(&_comm, &close_input);
+		}};
+
+		const auto max_scan_size = get_max_scan_size();
+		std::vector<char> buffer(static_cast<std::size_t>(chunk_size));
+
+		// Each chunk ends where the previous one began, so every byte below start is searched once.
+		for (auto end = start; start - end < max_scan_size;) {
+			const auto offset = std::max<rodsLong_t>(0, end - chunk_size);
+			const auto length = static_cast<int>(end - offset);
+
+			const auto read = read_at(_comm, fd, offset, buffer.data(), length);
+			if (read < 0) {
+				return read;
+			}
+
+			// If the data is shorter than the catalog says, only what was read is searched.
+			if (const auto* found = static_cast<const char*>(memrchr(buffer.data(), _delimiter, read)); found) {
+				_boundary = offset + (found - buffer.data()) + 1;
+				return 0;
+			}
+
+			end = offset;
+
+			if (0 == end) {
+				_boundary = 0;
+				return 0;
+			}
+		}
+
+		logging::info(logging::category::request,
+		              "{}: No delimiter found in the [{}] bytes of [{}] below [{}].",
+		              __func__,
+		              max_scan_size,
+		              _logical_path,
+		              start);
+
+		return SYS_INVALID_INPUT_PARAM;
+	} // find_record_boundary
+} // namespace irods::replica_truncate
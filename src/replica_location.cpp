@@ -0,0 +1,106 @@
+#include "irods/plugins/api/private/replica_location.hpp"
+
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/irods_hierarchy_parser.hpp>
+#include <irods/irods_resource_backport.hpp>
+#include <irods/irods_resource_constants.hpp>
+#include <irods/miscServerFunct.hpp>
+#include <irods/objInfo.h>
+#include <irods/rodsConnect.h>
+#include <irods/rodsDef.h>
+
+#include <cstring>
+#include <string>
+#include <tuple>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+
+	auto rank(const DataObjInfo& _replica)
+	{
+		// Lower is better, so every criterion is phrased as "is worse".
+		return std::make_tuple(!irods::replica_truncate::is_at_rest(_replica.replStatus),
+		                       GOOD_REPLICA != _replica.replStatus,
+		                       _replica.replNum);
+	} // rank
+
+	// Voting never picks a replica below a resource which is down, so local selection must not either.
+	auto is_down(const std::string_view _hierarchy) -> bool
+	{
+		irods::hierarchy_parser parser{std::string{_hierarchy}};
+
+		for (const auto& resource : parser) {
+			int status{};
+
+			if (const auto ret = irods::get_resource_property<int>(resource, irods::RESOURCE_STATUS, status); !ret.ok())
+			{
+				logging::debug(logging::category::selection,
+				               "{}: Could not get status of resource [{}]. Treating it as down.",
+				               __func__,
+				               resource);
+				return true;
+			}
+
+			if (INT_RESC_STATUS_DOWN == status) {
+				return true;
+			}
+		}
+
+		return false;
+	} // is_down
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto host_for_hierarchy(std::string_view _hierarchy) -> rodsServerHost*
+	{
+		std::string location;
+		if (const auto ec = host_of_hierarchy(_hierarchy, location); ec < 0) {
+			logging::debug(logging::category::selection,
+			               "{}: Could not get location of hierarchy [{}].",
+			               __func__,
+			               _hierarchy);
+			return nullptr;
+		}
+
+		rodsHostAddr_t addr{};
+		copy_into(addr.hostAddr, location);
+
+		rodsServerHost* host{};
+		if (resolveHost(&addr, &host) < 0) {
+			return nullptr;
+		}
+
+		return host;
+	} // host_for_hierarchy
+
+	auto is_local_hierarchy(std::string_view _hierarchy) -> bool
+	{
+		const auto* host = host_for_hierarchy(_hierarchy);
+		return host && LOCAL_HOST == host->localFlag;
+	} // is_local_hierarchy
+
+	auto select_local_replica(const DataObjInfo* _replicas) -> const DataObjInfo*
+	{
+		const DataObjInfo* best{};
+
+		for (const auto* replica = _replicas; replica; replica = replica->next) {
+			if (0 == std::strcmp(replica->rescName, BUNDLE_RESC)) {
+				continue;
+			}
+
+			if (!is_local_hierarchy(replica->rescHier) || is_down(replica->rescHier)) {
+				continue;
+			}
+
+			if (!best || rank(*replica) < rank(*best)) {
+				best = replica;
+			}
+		}
+
+		return best;
+	} // select_local_replica
+} // namespace irods::replica_truncate
@@ -0,0 +1,248 @@
+#include "irods/plugins/api/private/replica_snapshot.hpp"
+
+#include "irods/plugins/api/private/batch.hpp"
+#include "irods/plugins/api/private/data_snapshot.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/genQuery.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/objInfo.h>
+#include <irods/rcMisc.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rodsGenQuery.h>
+#include <irods/rodsKeyWdDef.h>
+#include <irods/rsGenQuery.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::genquery_literal;
+	using irods::replica_truncate::replica_snapshot;
+
+	// Keeps each condition well below the size the catalog accepts.
+	constexpr std::size_t max_names_per_query = 64;
+	constexpr std::size_t max_condition_size = 2048;
+
+	// Splits a logical path into its collection and data object name.
+	auto split(std::string_view _logical_path) -> std::pair<std::string_view, std::string_view>
+	{
+		const auto pos = _logical_path.rfind('/');
+		if (std::string_view::npos == pos || 0 == pos || pos + 1 == _logical_path.size()) {
+			return {};
+		}
+
+		return {_logical_path.substr(0, pos), _logical_path.substr(pos + 1)};
+	} // split
+
+	// Runs one query for the named data objects of one collection and adds their replicas to _replicas.
+	auto query_collection(RsComm& _comm,
+	                      std::string_view _collection,
+	                      const std::vector<std::string_view>& _names,
+	                      std::unordered_map<std::string, std::vector<replica_snapshot::replica>>& _replicas) -> int
+	{
+		genQueryInp_t gq_input{};
+		irods::at_scope_exit clear_gq_input{[&gq_input] { clearGenQueryInp(&gq_input); }};
+
+		addInxIval(&gq_input.selectInp, COL_DATA_NAME, 1);
+		addInxIval(&gq_input.selectInp, COL_DATA_REPL_NUM, 1);
+		addInxIval(&gq_input.selectInp, COL_DATA_SIZE, 1);
+		addInxIval(&gq_input.selectInp, COL_D_REPL_STATUS, 1);
+		addInxIval(&gq_input.selectInp, COL_D_RESC_HIER, 1);
+
+		const auto coll_condition = fmt::format("= {}", *genquery_literal(_collection));
+		addInxVal(&gq_input.sqlCondInp, COL_COLL_NAME, coll_condition.c_str());
+
+		auto name_condition = std::string{"in ("};
+		for (std::size_t i = 0; i < _names.size(); ++i) {
+			fmt::format_to(
+				std::back_inserter(name_condition), "{}{}", 0 == i ? "" : ", ", *genquery_literal(_names[i]));
+		}
+		name_condition += ')';
+		addInxVal(&gq_input.sqlCondInp, COL_DATA_NAME, name_condition.c_str());
+
+		// The catalog only returns data objects which the client may modify, as getDataObjInfo does for its access
+		// checks. Data objects left out are truncated the usual way, so the snapshot never tells a client more about
+		// a data object than a truncate of it would.
+		addKeyVal(&gq_input.condInput, USER_NAME_CLIENT_KW, _comm.clientUser.userName);
+		addKeyVal(&gq_input.condInput, RODS_ZONE_CLIENT_KW, _comm.clientUser.rodsZone);
+		addKeyVal(&gq_input.condInput, ACCESS_PERMISSION_KW, ACCESS_MODIFY_OBJECT);
+
+		gq_input.maxRows = MAX_SQL_ROWS;
+
+		// If we stop before the last page, the query must be closed so that the catalog can release its resources.
+		irods::at_scope_exit close_query{[&_comm, &gq_input] {
+			if (gq_input.continueInx > 0) {
+				GenQueryOut* gq_output{};
+				gq_input.maxRows = 0;
+				rsGenQuery(&_comm, &gq_input, &gq_output);
+				freeGenQueryOut(&gq_output);
+			}
+		}};
+
+		while (true) {
+			GenQueryOut* gq_output{};
+			irods::at_scope_exit free_gq_output{[&gq_output] { freeGenQueryOut(&gq_output); }};
+
+			if (const auto ec = rsGenQuery(&_comm, &gq_input, &gq_output); ec < 0) {
+				return CAT_NO_ROWS_FOUND == ec ? 0 : ec;
+			}
+
+			const auto* names = getSqlResultByInx(gq_output, COL_DATA_NAME);
+			const auto* repl_nums = getSqlResultByInx(gq_output, COL_DATA_REPL_NUM);
+			const auto* sizes = getSqlResultByInx(gq_output, COL_DATA_SIZE);
+			const auto* statuses = getSqlResultByInx(gq_output, COL_D_REPL_STATUS);
+			const auto* hierarchies = getSqlResultByInx(gq_output, COL_D_RESC_HIER);
+
+			for (int row = 0; row < gq_output->rowCnt; ++row) {
+				const auto value = [row](const SqlResult* _column) { return &_column->value[row * _column->len]; };
+
+				_replicas[fmt::format("{}/{}", _collection, value(names))].push_back(
+					{.replica_number = std::atoi(value(repl_nums)),
+				     .size = std::strtoll(value(sizes), nullptr, 10),
+				     .status = std::atoi(value(statuses)),
+				     .hierarchy = value(hierarchies)});
+			}
+
+			gq_input.continueInx = gq_output->continueInx;
+
+			if (gq_input.continueInx <= 0) {
+				return 0;
+			}
+		}
+	} // query_collection
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto replica_snapshot::fetch(RsComm& _comm, const std::vector<std::string_view>& _logical_paths) -> void
+	{
+		// Ordered so that each collection's names are contiguous, and so that the queries are issued in a stable
+		// order.
+		std::map<std::string_view, std::vector<std::string_view>> by_collection;
+
+		for (const auto path : _logical_paths) {
+			const auto [collection, name] = split(path);
+
+			// Paths which cannot be queried are left to truncate_replica.
+			if (!collection.empty() && genquery_literal(path)) {
+				by_collection[collection].push_back(name);
+			}
+		}
+
+		for (auto& [collection, names] : by_collection) {
+			std::sort(std::begin(names), std::end(names));
+			names.erase(std::unique(std::begin(names), std::end(names)), std::end(names));
+
+			std::vector<std::string_view> chunk;
+			std::size_t condition_size{};
+
+			const auto flush = [&, &collection = collection] {
+				if (chunk.empty()) {
+					return;
+				}
+
+				if (const auto ec = query_collection(_comm, collection, chunk, replicas_); ec < 0) {
+					logging::warn(logging::category::collection,
+					              "{}: Could not prefetch replicas in [{}]. Querying them one by one. [ec={}]",
+					              __func__,
+					              collection,
+					              ec);
+				}
+
+				chunk.clear();
+				condition_size = 0;
+			};
+
+			for (const auto name : names) {
+				if (chunk.size() == max_names_per_query || condition_size + name.size() + 4 > max_condition_size) {
+					flush();
+				}
+
+				chunk.push_back(name);
+				condition_size += name.size() + 4;
+			}
+
+			flush();
+		}
+	} // replica_snapshot::fetch
+
+	auto replica_snapshot::already_truncated(const batch_entry& _entry, const DataObjInp& _template) const -> bool
+	{
+		const auto itr = replicas_.find(std::string{_entry.logical_path});
+		if (itr == replicas_.end()) {
+			return false;
+		}
+
+		// With a delimiter, the size is a maximum, and only the data tells whether the replica ends with a record.
+		if (getValByKey(&_template.condInput, TRUNCATE_TO_DELIMITER_KW)) {
+			return false;
+		}
+
+		const auto* repl_num = getValByKey(&_template.condInput, REPL_NUM_KW);
+		const auto* resc_name = getValByKey(&_template.condInput, RESC_NAME_KW);
+		const auto* resc_hier = getValByKey(&_template.condInput, RESC_HIER_STR_KW);
+
+		// Input which truncate_replica rejects is left to it, so that it fails the same way for every data object.
+		if (repl_num && resc_name) {
+			return false;
+		}
+
+		const auto* mode_str = getValByKey(&_template.condInput, TRUNCATE_SNAPSHOT_KW);
+		if (mode_str && !to_snapshot_mode(mode_str)) {
+			return false;
+		}
+
+		// Mirror the replica selection of truncate_replica, as far as it can be known without voting. Without any
+		// selection, every replica is a candidate.
+		const auto is_candidate = [&](const replica& _r) {
+			if (_entry.replica_number) {
+				return *_entry.replica_number == _r.replica_number;
+			}
+
+			if (!_entry.resource.empty()) {
+				return _entry.resource == root_of(_r.hierarchy);
+			}
+
+			if (resc_hier) {
+				return resc_hier == _r.hierarchy;
+			}
+
+			if (repl_num) {
+				return std::to_string(_r.replica_number) == repl_num;
+			}
+
+			if (resc_name) {
+				return resc_name == root_of(_r.hierarchy);
+			}
+
+			return true;
+		};
+
+		bool any_candidate = false;
+
+		for (const auto& r : itr->second) {
+			if (!is_candidate(r)) {
+				continue;
+			}
+
+			if (!is_at_rest(r.status) || r.size != _entry.size) {
+				return false;
+			}
+
+			any_candidate = true;
+		}
+
+		return any_candidate;
+	} // replica_snapshot::already_truncated
+} // namespace irods::replica_truncate
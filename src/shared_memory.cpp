@@ -0,0 +1,117 @@
+#include "irods/plugins/api/private/shared_memory.hpp"
+
+#include <fmt/format.h>
+
+#include <boost/interprocess/exceptions.hpp>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <ctime>
+#include <string>
+
+namespace
+{
+	namespace bip = boost::interprocess;
+
+	// Changes to the layout of anything in the segment must change this, since the segment outlives the agents and an
+	// old segment would otherwise be read with the new layout.
+	constexpr int layout_version = 2;
+
+	// Large enough for every table the plugin keeps. Growing the segment requires removing it from /dev/shm while
+	// the server is stopped, so err on the side of too large.
+	constexpr std::size_t segment_size = 16 * 1024 * 1024;
+
+	auto segment_name() -> std::string
+	{
+		// Include the uid so that multiple servers on the same host (e.g. test environments) do not collide.
+		return fmt::format("irods_api_plugin_replica_truncate_v{}_{}", layout_version, getuid());
+	} // segment_name
+
+	// Whether _ec from locking the mutex means that the caller now holds it.
+	auto acquired(pthread_mutex_t& _mutex, int _ec) noexcept -> bool
+	{
+		if (EOWNERDEAD == _ec) {
+			// The owner died while holding the mutex. Unless it is marked consistent before it is unlocked, it can
+			// never be locked again.
+			pthread_mutex_consistent(&_mutex);
+			return true;
+		}
+
+		return 0 == _ec;
+	} // acquired
+} // anonymous namespace
+
+namespace irods::replica_truncate::shared_memory
+{
+	robust_mutex::robust_mutex()
+	{
+		pthread_mutexattr_t attr{};
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+		pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+
+		const auto ec = pthread_mutex_init(&mutex_, &attr);
+		pthread_mutexattr_destroy(&attr);
+
+		if (0 != ec) {
+			throw bip::interprocess_exception{"Could not initialize robust mutex."};
+		}
+	} // robust_mutex
+
+	robust_mutex::~robust_mutex()
+	{
+		pthread_mutex_destroy(&mutex_);
+	} // ~robust_mutex
+
+	auto robust_mutex::lock() -> void
+	{
+		if (!acquired(mutex_, pthread_mutex_lock(&mutex_))) {
+			throw bip::lock_exception{};
+		}
+	} // robust_mutex::lock
+
+	auto robust_mutex::try_lock() -> bool
+	{
+		return acquired(mutex_, pthread_mutex_trylock(&mutex_));
+	} // robust_mutex::try_lock
+
+	auto robust_mutex::try_lock_until(std::chrono::system_clock::time_point _time) -> bool
+	{
+		// pthread_mutex_timedlock measures against CLOCK_REALTIME, which is what the system clock is.
+		const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(_time.time_since_epoch());
+
+		timespec abs_time{};
+		abs_time.tv_sec = static_cast<std::time_t>(since_epoch.count() / 1'000'000'000);
+		abs_time.tv_nsec = static_cast<long>(since_epoch.count() % 1'000'000'000);
+
+		return acquired(mutex_, pthread_mutex_timedlock(&mutex_, &abs_time));
+	} // robust_mutex::try_lock_until
+
+	auto robust_mutex::unlock() -> void
+	{
+		pthread_mutex_unlock(&mutex_);
+	} // robust_mutex::unlock
+
+	auto segment() -> bip::managed_shared_memory&
+	{
+		// Each agent is its own process, so the segment is mapped lazily by every agent that needs it.
+		static bip::managed_shared_memory segment{bip::open_or_create, segment_name().c_str(), segment_size};
+		return segment;
+	} // segment
+
+	auto lock_for(mutex_type& _mutex, std::chrono::milliseconds _timeout) -> lock_type
+	{
+		if (!_mutex.try_lock_until(std::chrono::system_clock::now() + _timeout)) {
+			return lock_type{_mutex, bip::defer_lock};
+		}
+
+		return lock_type{_mutex, bip::accept_ownership};
+	} // lock_for
+
+	auto process_exists(pid_t _pid) noexcept -> bool
+	{
+		return 0 == kill(_pid, 0) || EPERM == errno;
+	} // process_exists
+} // namespace irods::replica_truncate::shared_memory
@@ -0,0 +1,220 @@
+#include "irods/plugins/api/private/truncate_collection.hpp"
+
+#include "irods/plugins/api/private/batch.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/deferred_notifications.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/genQuery.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/irods_exception.hpp>
+#include <irods/key_value_proxy.hpp>
+#include <irods/rcMisc.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rsGenQuery.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::batch_entry;
+	using irods::replica_truncate::batch_results;
+	using irods::replica_truncate::deadline;
+	using irods::replica_truncate::deferred_notifications;
+	using irods::replica_truncate::truncate_batch_entry;
+
+	// LIKE treats '_' and '%' in the collection name as wildcards, and GenQuery cannot escape them, so the query may
+	// return collections which are only similar to the one requested.
+	auto is_in_collection(const std::string_view _coll_name, const std::string_view _collection) -> bool
+	{
+		return _coll_name == _collection ||
+		       (_coll_name.size() > _collection.size() && _coll_name.starts_with(_collection) &&
+		        '/' == _coll_name[_collection.size()]);
+	} // is_in_collection
+
+	auto get_page_size(const DataObjInp& _input) -> int
+	{
+		const auto* page_size = getValByKey(&_input.condInput, TRUNCATE_PAGE_SIZE_KW);
+		if (!page_size) {
+			return MAX_SQL_ROWS;
+		}
+
+		try {
+			return std::clamp(std::stoi(page_size), 1, MAX_SQL_ROWS);
+		}
+		catch (const std::exception&) {
+			THROW(SYS_INVALID_INPUT_PARAM,
+			      fmt::format("Invalid value for [{}]: [{}]", TRUNCATE_PAGE_SIZE_KW, page_size));
+		}
+	} // get_page_size
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto truncate_collection(RsComm& _comm, DataObjInp& _input, nlohmann::json& _output) -> int
+	{
+		const auto cond_input = irods::experimental::make_key_value_proxy(_input.condInput);
+
+		// Inputs which cannot be put in a GenQuery condition are rejected.
+		const std::string_view collection = _input.objPath;
+		const auto collection_literal = genquery_literal(collection);
+		if (collection.empty() || !collection_literal) {
+			_output["message"] = fmt::format("Cannot truncate collection [{}]: Invalid collection path.", collection);
+			return SYS_INVALID_INPUT_PARAM;
+		}
+
+		genQueryInp_t gq_input{};
+		irods::at_scope_exit clear_gq_input{[&gq_input] { clearGenQueryInp(&gq_input); }};
+
+		addInxIval(&gq_input.selectInp, COL_COLL_NAME, 1);
+		addInxIval(&gq_input.selectInp, COL_DATA_NAME, 1);
+
+		const auto coll_condition =
+			fmt::format("= {} || like {}", *collection_literal, *genquery_literal(fmt::format("{}/%", collection)));
+		addInxVal(&gq_input.sqlCondInp, COL_COLL_NAME, coll_condition.c_str());
+
+		if (const auto itr = cond_input.find(TRUNCATE_NAME_LIKE_KW); itr != cond_input.cend()) {
+			const auto name_literal = genquery_literal((*itr).value());
+			if (!name_literal) {
+				_output["message"] = fmt::format(
+					"Cannot truncate collection [{}]: Invalid value for [{}].", collection, TRUNCATE_NAME_LIKE_KW);
+				return SYS_INVALID_INPUT_PARAM;
+			}
+
+			const auto name_condition = fmt::format("like {}", *name_literal);
+			addInxVal(&gq_input.sqlCondInp, COL_DATA_NAME, name_condition.c_str());
+		}
+
+		// Let the catalog filter out objects which are already small enough rather than visiting each of them.
+		if (cond_input.contains(TRUNCATE_ONLY_IF_LARGER_KW)) {
+			const auto size_condition = fmt::format("> '{}'", _input.dataSize);
+			addInxVal(&gq_input.sqlCondInp, COL_DATA_SIZE, size_condition.c_str());
+		}
+
+		gq_input.maxRows = get_page_size(_input);
+
+		const auto dl = deadline::from_input(_input);
+
+		// Firing the policy chain once per object can cost more than the truncates themselves.
+		std::optional<deferred_notifications> deferred;
+		if (cond_input.contains(TRUNCATE_DEFER_NOTIFICATIONS_KW)) {
+			deferred.emplace();
+		}
+		int notification_error{};
+
+		// If we stop before the last page, the query must be closed so that the catalog can release its resources.
+		irods::at_scope_exit close_query{[&_comm, &gq_input] {
+			if (gq_input.continueInx > 0) {
+				GenQueryOut* gq_output{};
+				gq_input.maxRows = 0;
+				rsGenQuery(&_comm, &gq_input, &gq_output);
+				freeGenQueryOut(&gq_output);
+			}
+		}};
+
+		batch_results results;
+
+		// Snapshots are registered next to the data objects they preserve, so the walk may come across the ones this
+		// request made. They are not truncated again.
+		std::unordered_set<std::string> snapshots;
+
+		// Called on every path out of the loop, so that the notifications for objects which were truncated are
+		// always delivered.
+		const auto make_summary = [&] {
+			results.write(_output);
+
+			if (deferred) {
+				notification_error = deferred->deliver(_comm);
+				_output["notifications"] = deferred->summary();
+			}
+		};
+
+		while (true) {
+			GenQueryOut* gq_output{};
+			irods::at_scope_exit free_gq_output{[&gq_output] { freeGenQueryOut(&gq_output); }};
+
+			if (const auto ec = rsGenQuery(&_comm, &gq_input, &gq_output); ec < 0) {
+				if (CAT_NO_ROWS_FOUND == ec) {
+					break;
+				}
+
+				make_summary();
+				_output["message"] =
+					fmt::format("Cannot truncate collection [{}]: Error occurred querying the catalog.", collection);
+				return ec;
+			}
+
+			const auto* coll_names = getSqlResultByInx(gq_output, COL_COLL_NAME);
+			const auto* data_names = getSqlResultByInx(gq_output, COL_DATA_NAME);
+
+			for (int row = 0; row < gq_output->rowCnt; ++row) {
+				// Stop walking the collection once the client has given up on the result.
+				if (dl.expired()) {
+					make_summary();
+					return dl.fail(_output, _input.objPath, "truncating remaining data objects");
+				}
+
+				const std::string_view coll_name = &coll_names->value[row * coll_names->len];
+
+				if (!is_in_collection(coll_name, collection)) {
+					continue;
+				}
+
+				const auto logical_path =
+					fmt::format("{}/{}", coll_name, &data_names->value[row * data_names->len]);
+
+				if (snapshots.contains(logical_path)) {
+					continue;
+				}
+
+				nlohmann::json object_output;
+				const auto ec = truncate_batch_entry(_comm,
+				                                     _input,
+				                                     batch_entry{.logical_path = logical_path, .size = _input.dataSize},
+				                                     deferred ? &*deferred : nullptr,
+				                                     object_output);
+
+				if (const auto snapshot = object_output.find("snapshot"); snapshot != object_output.end()) {
+					snapshots.insert(snapshot->value("logical_path", ""));
+				}
+
+				results.add(logical_path, ec, object_output);
+			}
+
+			gq_input.continueInx = gq_output->continueInx;
+
+			if (gq_input.continueInx <= 0) {
+				break;
+			}
+		}
+
+		make_summary();
+
+		if (results.failed() > 0) {
+			_output["message"] = fmt::format("Failed to truncate [{}] of [{}] data objects in [{}].",
+			                                 results.failed(),
+			                                 results.matched(),
+			                                 collection);
+			logging::info(logging::category::collection,
+			              "{}: {}",
+			              __func__,
+			              _output.at("message").get_ref<const std::string&>());
+		}
+		else if (notification_error < 0) {
+			_output["message"] = fmt::format(
+				"Truncated data objects in [{}], but some fileModified notifications failed.", collection);
+			return notification_error;
+		}
+
+		return results.first_error();
+	} // truncate_collection
+} // namespace irods::replica_truncate
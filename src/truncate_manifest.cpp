@@ -0,0 +1,436 @@
+#include "irods/plugins/api/private/truncate_manifest.hpp"
+
+#include "irods/plugins/api/private/batch.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/deferred_notifications.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/replica_snapshot.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/dataObjClose.h>
+#include <irods/dataObjInpOut.h>
+#include <irods/dataObjRead.h>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/key_value_proxy.hpp>
+#include <irods/rodsErrorTable.h>
+#include <irods/rsDataObjClose.hpp>
+#include <irods/rsDataObjOpen.hpp>
+#include <irods/rsDataObjRead.hpp>
+
+#include <fmt/format.h>
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::batch_entry;
+	using irods::replica_truncate::batch_results;
+	using irods::replica_truncate::deadline;
+	using irods::replica_truncate::deferred_notifications;
+	using irods::replica_truncate::replica_snapshot;
+	using irods::replica_truncate::truncate_batch_entry;
+
+	constexpr int chunk_size = 1024 * 1024;
+
+	// Entries are collected into windows of this many, so that the replicas of a whole window can be fetched from the
+	// catalog at once. Memory use stays bounded by the window.
+	constexpr std::size_t window_size = 256;
+
+	// An entry is a short JSON object, so a line longer than this is not an entry. Bounding it keeps memory use flat
+	// even for a manifest which is not made of lines at all.
+	constexpr std::size_t max_line_size = 64 * 1024;
+
+	auto trim(std::string_view _s) -> std::string_view
+	{
+		constexpr std::string_view whitespace = " \t\r";
+
+		const auto first = _s.find_first_not_of(whitespace);
+		if (std::string_view::npos == first) {
+			return {};
+		}
+
+		return _s.substr(first, _s.find_last_not_of(whitespace) - first + 1);
+	} // trim
+
+	// An entry waiting in the window. It owns its strings, unlike batch_entry.
+	struct manifest_entry
+	{
+		std::string logical_path;
+		rodsLong_t size{};
+		std::optional<int> replica_number;
+		std::string resource;
+
+		auto view() const -> batch_entry
+		{
+			return {.logical_path = logical_path,
+			        .size = size,
+			        .replica_number = replica_number,
+			        .resource = resource};
+		}
+	}; // struct manifest_entry
+
+	// Returns an error message if the line cannot be used.
+	auto parse_entry(const nlohmann::json& _record, rodsLong_t _default_size, manifest_entry& _entry)
+		-> std::optional<std::string>
+	{
+		if (!_record.is_object()) {
+			return "Not a JSON object.";
+		}
+
+		const auto path = _record.find("path");
+		if (path == _record.end() || !path->is_string()) {
+			return "Missing or invalid \"path\".";
+		}
+
+		_entry.logical_path = path->get_ref<const std::string&>();
+
+		if (const auto size = _record.find("size"); size != _record.end()) {
+			if (!size->is_number_integer() || size->get<rodsLong_t>() < 0) {
+				return "Invalid \"size\".";
+			}
+
+			_entry.size = size->get<rodsLong_t>();
+		}
+		else if (_default_size < 0) {
+			return "Missing \"size\", and the request has no default size.";
+		}
+		else {
+			_entry.size = _default_size;
+		}
+
+		const auto replica_number = _record.find("replica_number");
+		const auto resource = _record.find("resource");
+
+		if (replica_number != _record.end() && resource != _record.end()) {
+			return "\"replica_number\" and \"resource\" are incompatible.";
+		}
+
+		if (replica_number != _record.end()) {
+			if (!replica_number->is_number_integer() || replica_number->get<int>() < 0) {
+				return "Invalid \"replica_number\".";
+			}
+
+			_entry.replica_number = replica_number->get<int>();
+		}
+
+		if (resource != _record.end()) {
+			if (!resource->is_string() || resource->get_ref<const std::string&>().empty()) {
+				return "Invalid \"resource\".";
+			}
+
+			_entry.resource = resource->get_ref<const std::string&>();
+		}
+
+		return std::nullopt;
+	} // parse_entry
+
+	// Reads the manifest one chunk at a time and hands out complete lines.
+	class line_reader
+	{
+	  public:
+		line_reader(RsComm& _comm, int _fd)
+			: comm_{_comm}
+			, fd_{_fd}
+			, buffer_(chunk_size)
+		{
+		}
+
+		/// Returns false at the end of the manifest. Lines longer than max_line_size are returned empty with
+		/// too_long() set.
+		auto next(std::string_view& _line) -> bool
+		{
+			line_.clear();
+			too_long_ = false;
+
+			while (true) {
+				if (pos_ == end_) {
+					if (eof_) {
+						_line = line_;
+						return !line_.empty() || too_long_;
+					}
+
+					if (const auto ec = fill(); ec < 0) {
+						error_ = ec;
+						return false;
+					}
+
+					continue;
+				}
+
+				const auto* begin = buffer_.data() + pos_;
+				const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', end_ - pos_));
+				const auto length = newline ? static_cast<std::size_t>(newline - begin) : end_ - pos_;
+
+				if (!too_long_ && line_.size() + length > max_line_size) {
+					too_long_ = true;
+					line_.clear();
+				}
+
+				if (!too_long_) {
+					line_.append(begin, length);
+				}
+
+				pos_ += length;
+
+				if (newline) {
+					++pos_;
+					_line = line_;
+					return true;
+				}
+			}
+		} // next
+
+		auto too_long() const noexcept -> bool
+		{
+			return too_long_;
+		}
+
+		/// The error code of the read which failed, if any.
+		auto error() const noexcept -> int
+		{
+			return error_;
+		}
+
+	  private:
+		auto fill() -> int
+		{
+			OpenedDataObjInp inp{};
+			inp.l1descInx = fd_;
+			inp.len = chunk_size;
+
+			BytesBuf buf{};
+			buf.buf = buffer_.data();
+			buf.len = chunk_size;
+
+			const auto read = rsDataObjRead(&comm_, &inp, &buf);
+			if (read < 0) {
+				return read;
+			}
+
+			pos_ = 0;
+			end_ = static_cast<std::size_t>(read);
+			eof_ = 0 == read;
+
+			return 0;
+		} // fill
+
+		RsComm& comm_;
+		int fd_;
+		std::vector<char> buffer_;
+		std::size_t pos_{};
+		std::size_t end_{};
+		bool eof_{};
+		int error_{};
+		std::string line_;
+		bool too_long_{};
+	}; // class line_reader
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto truncate_manifest(RsComm& _comm, DataObjInp& _input, nlohmann::json& _output) -> int
+	{
+		const auto cond_input = irods::experimental::make_key_value_proxy(_input.condInput);
+
+		const std::string_view manifest = _input.objPath;
+
+		// The manifest is read with the client's own permissions.
+		DataObjInp open_input{};
+		irods::at_scope_exit clear_open_input{[&open_input] { clearKeyVal(&open_input.condInput); }};
+		copy_into(open_input.objPath, _input.objPath);
+		open_input.openFlags = O_RDONLY;
+
+		const auto fd = rsDataObjOpen(&_comm, &open_input);
+		if (fd < 0) {
+			_output["message"] = fmt::format("Cannot truncate data objects: Could not open manifest [{}].", manifest);
+			return fd;
+		}
+
+		irods::at_scope_exit close_manifest{[&_comm, fd] {
+			OpenedDataObjInp close_input{};
+			close_input.l1descInx = fd;
+			rsDataObjClose(&_comm, &close_input);
+		}};
+
+		const auto dl = deadline::from_input(_input);
+
+		// Firing the policy chain once per object can cost more than the truncates themselves.
+		std::optional<deferred_notifications> deferred;
+		if (cond_input.contains(TRUNCATE_DEFER_NOTIFICATIONS_KW)) {
+			deferred.emplace();
+		}
+		int notification_error{};
+
+		batch_results results;
+
+		// Called on every path out of the loop, so that the notifications for objects which were truncated are
+		// always delivered. Only the first call does anything.
+		bool summarized = false;
+		const auto make_summary = [&] {
+			if (std::exchange(summarized, true)) {
+				return;
+			}
+
+			results.write(_output);
+
+			if (deferred) {
+				notification_error = deferred->deliver(_comm);
+				_output["notifications"] = deferred->summary();
+			}
+		};
+
+		// Covers the paths out of the loop which are exceptions.
+		irods::at_scope_exit summarize_on_exception{[&] {
+			try {
+				make_summary();
+			}
+			catch (const std::exception& e) {
+				logging::error(logging::category::collection,
+				               "truncate_manifest: Could not deliver notifications for [{}]. [{}]",
+				               manifest,
+				               e.what());
+			}
+		}};
+
+		std::vector<manifest_entry> window;
+		window.reserve(window_size);
+
+		replica_snapshot snapshot;
+
+		// Returns the error code to stop with if the deadline passed.
+		const auto process_window = [&]() -> std::optional<int> {
+			std::vector<std::string_view> paths;
+			paths.reserve(window.size());
+			std::transform(std::begin(window), std::end(window), std::back_inserter(paths), [](const auto& _e) {
+				return std::string_view{_e.logical_path};
+			});
+
+			// One query per collection instead of one per data object. Data objects which already have the
+			// requested size are answered from the snapshot.
+			snapshot.clear();
+			snapshot.fetch(_comm, paths);
+
+			for (const auto& e : window) {
+				// Stop once the client has given up on the result.
+				if (dl.expired()) {
+					make_summary();
+					return dl.fail(_output, _input.objPath, "truncating remaining data objects");
+				}
+
+				const auto entry = e.view();
+
+				nlohmann::json object_output;
+
+				if (snapshot.already_truncated(entry, _input)) {
+					object_output = {{"truncated", false}};
+					results.add(entry.logical_path, 0, object_output);
+					continue;
+				}
+
+				const auto ec =
+					truncate_batch_entry(_comm, _input, entry, deferred ? &*deferred : nullptr, object_output);
+
+				results.add(entry.logical_path, ec, object_output);
+			}
+
+			window.clear();
+
+			return std::nullopt;
+		};
+
+		line_reader reader{_comm, fd};
+		std::uint64_t line_number{};
+		std::string_view line;
+
+		while (reader.next(line)) {
+			++line_number;
+
+			if (reader.too_long()) {
+				results.add_failure("",
+				                    SYS_INVALID_INPUT_PARAM,
+				                    fmt::format("Line [{}] is longer than [{}] bytes.", line_number, max_line_size));
+				continue;
+			}
+
+			line = trim(line);
+			if (line.empty()) {
+				continue;
+			}
+
+			// Each record is parsed on its own, so no document holding the whole manifest is ever built.
+			const auto record = nlohmann::json::parse(line, nullptr, false);
+			if (record.is_discarded()) {
+				results.add_failure(
+					"", SYS_INVALID_INPUT_PARAM, fmt::format("Line [{}] is not valid JSON.", line_number));
+				continue;
+			}
+
+			manifest_entry entry;
+			if (const auto error = parse_entry(record, _input.dataSize, entry); error) {
+				// The path is only reported if it is a string. find() also handles records which are not objects.
+				std::string_view path;
+				if (const auto p = record.find("path"); p != record.end() && p->is_string()) {
+					path = p->get_ref<const std::string&>();
+				}
+
+				results.add_failure(path,
+				                    SYS_INVALID_INPUT_PARAM,
+				                    fmt::format("Line [{}]: {}", line_number, *error));
+				continue;
+			}
+
+			window.push_back(std::move(entry));
+
+			if (window.size() == window_size) {
+				if (const auto ec = process_window(); ec) {
+					return *ec;
+				}
+			}
+		}
+
+		// A read error still lets the entries which were read be processed.
+		if (const auto ec = process_window(); ec) {
+			return *ec;
+		}
+
+		make_summary();
+
+		if (reader.error() < 0) {
+			_output["message"] = fmt::format(
+				"Cannot truncate data objects: Error occurred reading manifest [{}] after line [{}].",
+				manifest,
+				line_number);
+			return reader.error();
+		}
+
+		if (results.failed() > 0) {
+			_output["message"] = fmt::format("Failed to truncate [{}] of [{}] data objects listed in [{}].",
+			                                 results.failed(),
+			                                 results.matched(),
+			                                 manifest);
+			logging::info(logging::category::collection,
+			              "{}: {}",
+			              __func__,
+			              _output.at("message").get_ref<const std::string&>());
+		}
+		else if (notification_error < 0) {
+			_output["message"] = fmt::format(
+				"Truncated data objects listed in [{}], but some fileModified notifications failed.", manifest);
+			return notification_error;
+		}
+
+		return results.first_error();
+	} // truncate_manifest
+} // namespace irods::replica_truncate
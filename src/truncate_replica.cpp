@@ -0,0 +1,752 @@
+#include "irods/plugins/api/private/truncate_replica.hpp"
+
+#include "irods/plugins/api/private/admission_control.hpp"
+#include "irods/plugins/api/private/coalesced_truncate.hpp"
+#include "irods/plugins/api/private/compound_tiers.hpp"
+#include "irods/plugins/api/private/configuration.hpp"
+#include "irods/plugins/api/private/copy_truncate.hpp"
+#include "irods/plugins/api/private/data_snapshot.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/deferred_notifications.hpp"
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/record_boundary.hpp"
+#include "irods/plugins/api/private/replica_location.hpp"
+#include "irods/plugins/api/private/usage_ledger.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+
+#include <irods/data_object_proxy.hpp>
+#include <irods/irods_at_scope_exit.hpp>
+#include <irods/irods_exception.hpp>
+#include <irods/irods_file_object.hpp>
+#include <irods/irods_query.hpp>
+#include <irods/irods_resource_redirect.hpp>
+#include <irods/key_value_proxy.hpp>
+#include <irods/miscServerFunct.hpp>
+#include <irods/modDataObjMeta.h>
+#include <irods/procApiRequest.h>
+#include <irods/rcMisc.h>
+#include <irods/replica_proxy.hpp>
+#include <irods/rodsConnect.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rsFileTruncate.hpp>
+#include <irods/rsModDataObjMeta.hpp>
+
+#include <fmt/format.h>
+
+#include <boost/make_shared.hpp> // Needed for irods::file_object_ptr, which is a boost::shared_ptr...
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+	namespace data_object = irods::experimental::data_object;
+	namespace logging = irods::replica_truncate::logging;
+	using irods::replica_truncate::admission_permit;
+	using irods::replica_truncate::coalesced_truncate;
+	using irods::replica_truncate::compound_tier;
+	using irods::replica_truncate::copy_into;
+	using irods::replica_truncate::copy_truncate;
+	using irods::replica_truncate::data_snapshot;
+	using irods::replica_truncate::deadline;
+	using irods::replica_truncate::deferred_notifications;
+	using irods::replica_truncate::find_record_boundary;
+	using irods::replica_truncate::host_of_hierarchy;
+	using irods::replica_truncate::is_at_rest;
+	using irods::replica_truncate::is_local_hierarchy;
+	using irods::replica_truncate::is_truncate_unsupported;
+	using irods::replica_truncate::notify_modified;
+	using irods::replica_truncate::record_usage_change;
+	using irods::replica_truncate::remove_snapshot;
+	using irods::replica_truncate::snapshot_physical_data;
+	using irods::replica_truncate::to_priority;
+	using replica_proxy_type = irods::experimental::replica::replica_proxy<DataObjInfo>;
+
+	auto truncate_physical_data(RsComm& _comm,
+	                            const std::string_view _physical_path,
+	                            const std::string_view _hierarchy,
+	                            rodsLong_t _length) -> int
+	{
+		std::string location{};
+		if (const auto ec = host_of_hierarchy(_hierarchy, location); ec < 0) {
+			return ec;
+		}
+
+		fileOpenInp_t inp{};
+		copy_into(inp.fileName, _physical_path);
+		copy_into(inp.resc_hier_, _hierarchy);
+		copy_into(inp.addr.hostAddr, location);
+		inp.dataSize = _length;
+
+		return rsFileTruncate(&_comm, &inp);
+	} // truncate_physical_data
+
+	// Parse the value of TRUNCATE_WAIT_FOR_AT_REST_KW, capped by the server's configured maximum.
+	auto get_wait_for_at_rest_timeout(const DataObjInp& _input) -> std::chrono::milliseconds
+	{
+		const auto* value = getValByKey(&_input.condInput, TRUNCATE_WAIT_FOR_AT_REST_KW);
+		if (!value) {
+			return std::chrono::milliseconds{0};
+		}
+
+		std::chrono::milliseconds requested{};
+
+		try {
+			requested = std::chrono::milliseconds{std::stoll(value)};
+		}
+		catch (const std::exception&) {
+			THROW(SYS_INVALID_INPUT_PARAM,
+			      fmt::format("Invalid value for [{}]: [{}]", TRUNCATE_WAIT_FOR_AT_REST_KW, value));
+		}
+
+		const auto maximum = std::chrono::seconds{
+			irods::replica_truncate::plugin_configuration().value("max_wait_for_at_rest_in_seconds", 60)};
+
+		return std::clamp<std::chrono::milliseconds>(requested, std::chrono::milliseconds{0}, maximum);
+	} // get_wait_for_at_rest_timeout
+
+	// Wait for the replica to come to rest by polling only its status in the catalog, rather than repeating the
+	// whole pipeline. On success, the status and size of _replica are refreshed.
+	auto wait_for_at_rest(RsComm& _comm, replica_proxy_type& _replica, std::chrono::milliseconds _timeout) -> int
+	{
+		// The replica is identified by numbers only. GenQuery cannot escape quotes in a logical path, and names may
+		// contain LIKE wildcards.
+		const auto query_str =
+			fmt::format("select DATA_REPL_STATUS, DATA_SIZE where DATA_ID = '{}' and DATA_REPL_NUM = '{}'",
+		                _replica.data_id(),
+		                _replica.replica_number());
+
+		const auto give_up_at = std::chrono::steady_clock::now() + _timeout;
+		auto backoff = std::chrono::milliseconds{50};
+
+		while (std::chrono::steady_clock::now() < give_up_at) {
+			std::this_thread::sleep_for(
+				std::min<std::chrono::steady_clock::duration>(backoff, give_up_at - std::chrono::steady_clock::now()));
+			backoff = std::min(backoff * 2, std::chrono::milliseconds{1000});
+
+			irods::query<RsComm> query{&_comm, query_str};
+			if (query.size() == 0) {
+				return SYS_REPLICA_DOES_NOT_EXIST;
+			}
+
+			const auto row = query.front();
+			const auto status = std::stoi(row[0]);
+
+			if (is_at_rest(status)) {
+				_replica.replica_status(status);
+				_replica.size(std::stoll(row[1]));
+				return 0;
+			}
+		}
+
+		return LOCKED_DATA_OBJECT_ACCESS;
+	} // wait_for_at_rest
+
+	// Whether the operation may be handed off to the server which hosts the storage of the target replica.
+	auto may_redirect(const DataObjInp& _input) -> bool
+	{
+		// A request which was already redirected is never redirected again, even if the servers disagree about who
+		// hosts the storage. That would bounce the request back and forth forever.
+		if (getValByKey(&_input.condInput, TRUNCATE_REDIRECTED_KW)) {
+			return false;
+		}
+
+		return irods::replica_truncate::plugin_configuration().value("redirect_to_owning_server", true);
+	} // may_redirect
+
+	// Hand the whole operation off to _host with the hierarchy already resolved, the way data object open does.
+	auto redirect_to_owning_server(RsComm& _comm,
+	                               rodsServerHost& _host,
+	                               const DataObjInp& _input,
+	                               const std::string& _hierarchy,
+	                               nlohmann::json& _output) -> int
+	{
+		if (const auto ec = svrToSvrConnect(&_comm, &_host); ec < 0) {
+			_output["message"] = fmt::format(
+				"Cannot truncate object [{}]: Could not connect to server hosting the replica.", _input.objPath);
+			return ec;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_cond_input{[&input] { clearKeyVal(&input.condInput); }};
+
+		copy_into(input.objPath, _input.objPath);
+		input.dataSize = _input.dataSize;
+		replKeyVal(&_input.condInput, &input.condInput);
+		addKeyVal(&input.condInput, RESC_HIER_STR_KW, _hierarchy.c_str());
+		addKeyVal(&input.condInput, TRUNCATE_REDIRECTED_KW, "");
+
+		BytesBuf* output{};
+		irods::at_scope_exit free_output{[&output] { freeBBuf(output); }};
+
+		const auto ec = procApiRequest(_host.conn,
+		                               APN_REPLICA_TRUNCATE,
+		                               &input,
+		                               nullptr,
+		                               reinterpret_cast<void**>(&output), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		                               nullptr);
+
+		if (output && output->buf && output->len > 0) {
+			_output.update(nlohmann::json::parse(static_cast<char*>(output->buf)));
+		}
+
+		return ec;
+	} // redirect_to_owning_server
+
+	// Whether the replica on the other tier of a compound resource can be truncated along with the target replica.
+	auto may_truncate_tiers_in_place(const replica_proxy_type& _replica,
+	                                 compound_tier _tier,
+	                                 const DataObjInfo& _other,
+	                                 rodsLong_t _old_size) -> bool
+	{
+		if (!irods::replica_truncate::truncates_tiers_in_place()) {
+			return false;
+		}
+
+		// Both replicas must hold the same data before the truncate for them to hold the same data after it.
+		if (GOOD_REPLICA != _replica.replica_status() || GOOD_REPLICA != _other.replStatus ||
+		    _other.dataSize != _old_size)
+		{
+			return false;
+		}
+
+		// The cache is expected to be on disk. The archive may well be on tape.
+		return compound_tier::archive == _tier || irods::replica_truncate::archive_can_truncate(_other.rescHier);
+	} // may_truncate_tiers_in_place
+
+	// Validate the target replica and truncate it.
+	auto truncate_target_replica(RsComm& _comm,
+	                             DataObjInp& _input,
+	                             DataObjInfo* _replicas,
+	                             replica_proxy_type& _replica,
+	                             const deadline& _deadline,
+	                             deferred_notifications* _deferred,
+	                             nlohmann::json& _output) -> int
+	{
+		// This would be handled by voting, so... there's not much to be done.
+		// Check that the object is at rest ahead of time so that we can get a detailed message.
+		if (!_replica.at_rest()) {
+			// Waiting here saves clients from polling, which would repeat the whole pipeline each time.
+			const auto timeout = _deadline.cap(get_wait_for_at_rest_timeout(_input));
+
+			if (const auto ec = timeout.count() > 0 ? wait_for_at_rest(_comm, _replica, timeout)
+			                                        : LOCKED_DATA_OBJECT_ACCESS;
+			    ec < 0)
+			{
+				_output["message"] = fmt::format("Cannot truncate object [{}]: Object is not at rest.", _input.objPath);
+				return ec;
+			}
+		}
+
+		// I'm not even really sure whether this situation is possible... Leaving it here just in case.
+		if (_replica.resource() == BUNDLE_RESC) {
+			_output["message"] =
+				fmt::format("Cannot truncate object [{}]: Replica targeted for truncate resides on [{}]. Skipping.",
+			                _input.objPath,
+			                BUNDLE_RESC);
+			return 0;
+		}
+
+		// The old truncate API skipped updating the catalog when the object is in a special collection, and so
+		// shall we. In fact, we should not touch the object at all in this case because it is unclear what to do.
+		if (_replica.special_collection_info()) {
+			_output["message"] =
+				fmt::format("Cannot truncate object [{}]: Object is in a special collection.", _input.objPath);
+			return 0;
+		}
+
+		// With a delimiter, dataSize is only the maximum size. The size is known once the data has been searched.
+		const auto* delimiter = getValByKey(&_input.condInput, TRUNCATE_TO_DELIMITER_KW);
+
+		if (!delimiter && _replica.size() == _input.dataSize) {
+			// Why, it's already the requested size. Done!
+			_output["message"] = fmt::format(
+				"Replica of [{}] targeted for truncate already has size [{}].", _input.objPath, _input.dataSize);
+			return 0;
+		}
+
+		// Hold admission for both the physical truncate and the catalog update so that bulk work cannot crowd out
+		// interactive users of the same storage.
+		const auto* priority_str = getValByKey(&_input.condInput, TRUNCATE_PRIORITY_KW);
+		const admission_permit permit{
+			_replica.hierarchy(), to_priority(priority_str ? priority_str : ""), _deadline};
+		if (_deadline.expired()) {
+			return _deadline.fail(_output, _input.objPath, "physical truncate");
+		}
+
+		if (!permit.admitted()) {
+			_output["message"] =
+				fmt::format("Cannot truncate object [{}]: Timed out waiting for admission to resource [{}].",
+			                _input.objPath,
+			                permit.resource());
+			return SYS_MAX_CONNECT_COUNT_EXCEEDED;
+		}
+
+		if (delimiter) {
+			// Searching on the storage host saves the client from reading the tail of the data to find the boundary.
+			rodsLong_t boundary{};
+			if (const auto ec = find_record_boundary(_comm,
+			                                         _input.objPath,
+			                                         _replica.physical_path(),
+			                                         _replica.hierarchy(),
+			                                         *delimiter,
+			                                         _input.dataSize,
+			                                         _replica.size(),
+			                                         boundary);
+			    ec < 0)
+			{
+				_output["message"] = fmt::format("Cannot truncate object [{}]: Error occurred searching for the last "
+				                                 "record ending at or below [{}].",
+				                                 _input.objPath,
+				                                 _input.dataSize);
+				return ec;
+			}
+
+			_input.dataSize = boundary;
+			_output["size"] = boundary;
+
+			if (_replica.size() == boundary) {
+				_output["message"] = fmt::format(
+					"Replica of [{}] targeted for truncate already ends with a complete record.", _input.objPath);
+				return 0;
+			}
+		}
+
+		// The ledger needs the size from before the truncate.
+		const auto old_size = _replica.size();
+
+		// Replicas in a compound resource are reported by tier, and the other tier may be truncated along with this
+		// one.
+		const auto compound = irods::replica_truncate::find_compound_position(_replica.hierarchy());
+		auto* other_tier = compound ? irods::replica_truncate::find_other_tier(_replicas, *compound) : nullptr;
+
+		// Keep a copy of the data which is about to be thrown away, if the client asked for one.
+		std::optional<data_snapshot> snapshot;
+
+		if (const auto* mode_str = getValByKey(&_input.condInput, TRUNCATE_SNAPSHOT_KW); mode_str) {
+			snapshot.emplace();
+
+			if (const auto ec = snapshot_physical_data(_comm,
+			                                           _input.objPath,
+			                                           _replica.physical_path(),
+			                                           _replica.hierarchy(),
+			                                           old_size,
+			                                           *irods::replica_truncate::to_snapshot_mode(mode_str),
+			                                           *snapshot);
+			    ec < 0)
+			{
+				_output["message"] = fmt::format(
+					"Cannot truncate object [{}]: Error occurred making a snapshot of the data with mode [{}]. "
+					"Data not truncated.",
+					_input.objPath,
+					mode_str);
+				return ec;
+			}
+
+			_output["snapshot"] = {{"logical_path", snapshot->logical_path},
+			                       {"physical_path", snapshot->physical_path},
+			                       {"resource_hierarchy", _replica.hierarchy()},
+			                       {"method", snapshot->method}};
+		}
+
+		// First, truncate the data...
+		const char* method = "native";
+
+		if (auto ec = truncate_physical_data(_comm, _replica.physical_path(), _replica.hierarchy(), _input.dataSize);
+		    ec < 0)
+		{
+			// Some resources cannot truncate at all. If the client accepts the cost, copy the part of the data which
+			// is kept instead. Every byte of the copy is read and written by this server, so it is only made by the
+			// server which hosts the storage. Anywhere else, the data would cross the network twice.
+			bool copy_refused = false;
+
+			if (is_truncate_unsupported(ec) && getValByKey(&_input.condInput, TRUNCATE_ALLOW_COPY_KW)) {
+				if (is_local_hierarchy(_replica.hierarchy())) {
+					method = "copy";
+					ec = copy_truncate(
+						_comm, _input.objPath, _replica.physical_path(), _replica.hierarchy(), _input.dataSize);
+				}
+				else {
+					copy_refused = true;
+				}
+			}
+
+			// The catalog must not describe data which does not exist.
+			if (ec < 0) {
+				// The data is unchanged, so the snapshot would only be a duplicate left for someone to clean up.
+				if (snapshot) {
+					if (const auto remove_ec = remove_snapshot(_comm, *snapshot); remove_ec < 0) {
+						logging::warn(logging::category::request,
+						              "{}: Could not remove snapshot [{}] after failed truncate. [ec={}]",
+						              __func__,
+						              snapshot->logical_path,
+						              remove_ec);
+					}
+					else {
+						_output.erase("snapshot");
+					}
+				}
+
+				if (copy_refused) {
+					_output["message"] = fmt::format(
+						"Cannot truncate object [{}]: The resource cannot truncate natively, and the data is only "
+						"copied by the server hosting the replica. Catalog not updated.",
+						_input.objPath);
+					return ec;
+				}
+
+				_output["message"] =
+					fmt::format("Cannot truncate object [{}]: Error occurred truncating the data using method [{}]. "
+				                "Catalog not updated.",
+				                _input.objPath,
+				                method);
+				return ec;
+			}
+		}
+
+		// From here on, a failure leaves the data truncated. Retries of the request must not be told otherwise.
+		_output["data_truncated"] = true;
+
+		// A compound resource replicates the whole of a modified cache replica to its archive, and leaves the cache
+		// replica stale when the archive replica is modified. If the other tier can truncate natively, truncating it
+		// as well leaves nothing to replicate.
+		bool other_tier_truncated = false;
+
+		if (other_tier && may_truncate_tiers_in_place(_replica, compound->tier, *other_tier, old_size)) {
+			if (const auto ec =
+			        truncate_physical_data(_comm, other_tier->filePath, other_tier->rescHier, _input.dataSize);
+			    ec < 0)
+			{
+				// The compound resource will replicate the target replica instead, as it would have anyway.
+				logging::warn(logging::category::request,
+				              "{}: Could not truncate replica of [{}] in [{}] in place. [ec={}]",
+				              __func__,
+				              _input.objPath,
+				              other_tier->rescHier,
+				              ec);
+			}
+			else {
+				other_tier_truncated = true;
+			}
+		}
+
+		// clang-format off
+		auto [register_keywords, register_keywords_lm] = irods::experimental::make_key_value_proxy(
+			{
+				// This updates the statuses of the other replicas to stale.
+				{ALL_REPL_STATUS_KW, ""},
+				// This updates the size of the replica.
+				{DATA_SIZE_KW, std::to_string(_input.dataSize)},
+				// This CLEARS the checksum... hmm...
+				{CHKSUM_KW, ""}
+			});
+		// clang-format on
+
+		// Include OPEN_TYPE_KW in order to trigger fileModified, unless the caller will trigger it later. When both
+		// tiers were truncated, fileModified is triggered below, once the catalog says which replicas are good.
+		const bool notified_by_update = !_deferred && !other_tier_truncated;
+
+		if (notified_by_update) {
+			register_keywords[OPEN_TYPE_KW] = std::to_string(OPEN_FOR_WRITE_TYPE);
+		}
+
+		ModDataObjMetaInp inp{_replica.get(), register_keywords.get()};
+
+		// Once the data has been truncated, the catalog must be updated regardless of the deadline. Abandoning the
+		// request here would leave the catalog inconsistent with the data.
+
+		if (const int ec = rsModDataObjMeta(&_comm, &inp); ec < 0) {
+			_output["message"] = fmt::format("Error occurred updating replica information for [{}] "
+			                                 "after truncate. Catalog may be inconsistent with data.",
+			                                 _input.objPath);
+			return ec;
+		}
+
+		_output["truncated"] = true;
+		_output["method"] = method;
+
+		const auto owner = fmt::format("{}#{}", _replica.get()->dataOwnerName, _replica.get()->dataOwnerZone);
+
+		record_usage_change(_replica.hierarchy(), owner, old_size, _input.dataSize);
+
+		if (other_tier_truncated) {
+			// The update above marked the other replica stale. It holds the same data again, so mark it good.
+			// clang-format off
+			auto [other_keywords, other_keywords_lm] = irods::experimental::make_key_value_proxy(
+				{
+					{DATA_SIZE_KW, std::to_string(_input.dataSize)},
+					{REPL_STATUS_KW, std::to_string(GOOD_REPLICA)},
+					{CHKSUM_KW, ""}
+				});
+			// clang-format on
+
+			ModDataObjMetaInp other_inp{other_tier, other_keywords.get()};
+
+			if (const int ec = rsModDataObjMeta(&_comm, &other_inp); ec < 0) {
+				// Stale is the truth as far as the catalog can tell, so there is nothing to undo.
+				logging::warn(logging::category::request,
+				              "{}: Could not update replica of [{}] in [{}] after truncating it in place. [ec={}]",
+				              __func__,
+				              _input.objPath,
+				              other_tier->rescHier,
+				              ec);
+				other_tier_truncated = false;
+			}
+			else {
+				record_usage_change(other_tier->rescHier, owner, old_size, _input.dataSize);
+			}
+		}
+
+		if (compound) {
+			auto& tiers = _output["tiers"];
+			tiers[irods::replica_truncate::to_string(compound->tier)] = "truncated";
+
+			if (other_tier) {
+				const auto other =
+					compound_tier::cache == compound->tier ? compound_tier::archive : compound_tier::cache;
+
+				// A truncated cache replica is replicated to the archive by the compound resource on fileModified.
+				if (other_tier_truncated) {
+					tiers[irods::replica_truncate::to_string(other)] = "truncated";
+				}
+				else {
+					tiers[irods::replica_truncate::to_string(other)] =
+						compound_tier::cache == compound->tier ? "replicated" : "stale";
+				}
+			}
+		}
+
+		if (notified_by_update) {
+			return 0;
+		}
+
+		_replica.size(_input.dataSize);
+
+		// A compound resource replicates a modified cache replica to its archive, but has nothing to do for a
+		// modified archive replica. When both tiers hold the truncated data, fileModified is triggered for the
+		// archive replica so that only the resources above the compound resource act on it.
+		auto* modified = _replica.get();
+
+		if (other_tier_truncated) {
+			other_tier->dataSize = _input.dataSize;
+			other_tier->replStatus = GOOD_REPLICA;
+
+			if (compound_tier::cache == compound->tier) {
+				modified = other_tier;
+			}
+		}
+
+		if (_deferred) {
+			_deferred->add(*modified);
+			return 0;
+		}
+
+		if (const auto ec = notify_modified(_comm, *modified); ec < 0) {
+			_output["message"] = fmt::format("Error occurred notifying resources of the truncate of [{}] in [{}].",
+			                                 _input.objPath,
+			                                 modified->rescHier);
+			return ec;
+		}
+
+		return 0;
+	} // truncate_target_replica
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto truncate_replica(RsComm& _comm,
+	                      DataObjInp& _input,
+	                      nlohmann::json& _output,
+	                      deferred_notifications* _deferred) -> int
+	{
+		_output["message"] = "";
+		_output["truncated"] = false;
+
+		// Every phase below is expensive, so check before each one whether the client is still waiting.
+		const auto dl = deadline::from_input(_input);
+		if (dl.expired()) {
+			return dl.fail(_output, _input.objPath, "getting data object info");
+		}
+
+		const auto cond_input = irods::experimental::make_key_value_proxy(_input.condInput);
+
+		// Get the target_resource and replica_number options. Ensure that they are not being used at the same time
+		// because they are incompatible parameters. They are incompatible parameters because they can contradict
+		// one another as to what the user is instructing the API to do.
+		const auto resc_name_itr = cond_input.find(RESC_NAME_KW);
+		const auto repl_num_itr = cond_input.find(REPL_NUM_KW);
+		if (resc_name_itr != cond_input.cend() && repl_num_itr != cond_input.cend()) {
+			_output["message"] = fmt::format("Cannot truncate object [{}]: '{}' and '{}' are incompatible options.",
+			                                 _input.objPath,
+			                                 RESC_NAME_KW,
+			                                 REPL_NUM_KW);
+			return USER_INCOMPATIBLE_PARAMS;
+		}
+
+		const auto delimiter_itr = cond_input.find(TRUNCATE_TO_DELIMITER_KW);
+		if (delimiter_itr != cond_input.cend() && 1 != (*delimiter_itr).value().size()) {
+			_output["message"] = fmt::format(
+				"Cannot truncate object [{}]: '{}' must be a single byte.", _input.objPath, TRUNCATE_TO_DELIMITER_KW);
+			return SYS_INVALID_INPUT_PARAM;
+		}
+
+		if (const auto mode = cond_input.find(TRUNCATE_SNAPSHOT_KW);
+		    mode != cond_input.cend() && !irods::replica_truncate::to_snapshot_mode((*mode).value()))
+		{
+			_output["message"] = fmt::format("Cannot truncate object [{}]: '{}' must be 'clone' or 'clone_or_copy'.",
+			                                 _input.objPath,
+			                                 TRUNCATE_SNAPSHOT_KW);
+			return SYS_INVALID_INPUT_PARAM;
+		}
+
+		// Now, onto the truncating.
+
+		// boost::make_shared is used here because irods::file_object_ptr is a boost::shared_ptr.
+		irods::file_object_ptr file_obj = boost::make_shared<irods::file_object>();
+		file_obj->logical_path(_input.objPath);
+
+		// This is only required for the file_object_factory, which is required for the resolve hierarchy
+		// interface.
+		DataObjInfo* data_obj_info{};
+		irods::at_scope_exit free_data_object_info{[&data_obj_info] { freeAllDataObjInfo(data_obj_info); }};
+
+		const auto fac_err = irods::file_object_factory(&_comm, &_input, file_obj, &data_obj_info);
+		if (!fac_err.ok() || !data_obj_info) {
+			_output["message"] =
+				fmt::format("Cannot truncate object [{}]: Error occurred getting data object info.", _input.objPath);
+			return static_cast<int>(fac_err.code());
+		}
+
+		// Locality-aware selection only applies when the client left the choice of replica to the server.
+		const auto server_selects = resc_name_itr == cond_input.cend() && repl_num_itr == cond_input.cend() &&
+		                            !cond_input.contains(RESC_HIER_STR_KW);
+		const auto select_local = server_selects && cond_input.contains(TRUNCATE_REPLICA_SELECTION_KW) &&
+		                          "local" == (*cond_input.find(TRUNCATE_REPLICA_SELECTION_KW)).value();
+
+		// Voting on a data object whose only replica is in the archive of a compound resource would stage the whole
+		// replica into the cache just to truncate it.
+		const auto* archive_only =
+			server_selects && !select_local && irods::replica_truncate::truncates_tiers_in_place()
+				? irods::replica_truncate::select_archive_only_replica(data_obj_info)
+				: nullptr;
+
+		if (dl.expired()) {
+			return dl.fail(_output, _input.objPath, "resolving resource hierarchy");
+		}
+
+		// Preferring a replica on this server saves a server-to-server hop for the physical truncate.
+		const auto* local_replica =
+			select_local ? irods::replica_truncate::select_local_replica(data_obj_info) : nullptr;
+
+		if (select_local && !local_replica) {
+			logging::info(logging::category::selection,
+			              "{}: No replica of [{}] on this server is eligible for truncate. Resolving by vote instead.",
+			              __func__,
+			              _input.objPath);
+		}
+
+		std::string hierarchy{};
+		if (local_replica) {
+			hierarchy = local_replica->rescHier;
+		}
+		else if (archive_only) {
+			logging::info(logging::category::selection,
+			              "{}: Truncating archive replica of [{}] in [{}] in place instead of staging it.",
+			              __func__,
+			              _input.objPath,
+			              archive_only->rescHier);
+			hierarchy = archive_only->rescHier;
+		}
+		else if (const auto hier_str = cond_input.find(RESC_HIER_STR_KW); hier_str == cond_input.cend()) {
+			// Don't look too closely at this - may cause eye irritation.
+			auto resolve_hierarchy_tuple = std::make_tuple(file_obj, fac_err);
+			std::tie(file_obj, hierarchy) =
+				irods::resolve_resource_hierarchy(&_comm, irods::WRITE_OPERATION, _input, resolve_hierarchy_tuple);
+		}
+		else {
+			// Leave a note in the logs because this is technically bypassing policy despite being an iRODS pattern.
+			logging::info(logging::category::selection,
+			              "{}: [{}] keyword used to bypass hierarchy resolution for [{}].",
+			              __func__,
+			              RESC_HIER_STR_KW,
+			              _input.objPath);
+			hierarchy = (*hier_str).value().data();
+		}
+
+		auto target_object = data_object::make_data_object_proxy(*data_obj_info);
+		auto target_replica = data_object::find_replica(target_object, hierarchy);
+		if (!target_replica) {
+			_output["message"] = fmt::format(
+				"Cannot truncate object [{}]: No replica found in requested hierarchy [{}].", _input.objPath, hierarchy);
+			return SYS_REPLICA_DOES_NOT_EXIST;
+		}
+
+		// Let the client know which replica was chosen, since the server may have done the choosing.
+		_output["replica_number"] = target_replica->replica_number();
+		_output["resource_hierarchy"] = target_replica->hierarchy();
+
+		if (dl.expired()) {
+			return dl.fail(_output, _input.objPath, "truncating replica");
+		}
+
+		// The physical truncate is a local operation on the server which hosts the storage. Handing the whole
+		// operation to that server saves a server-to-server round trip for every call made against the storage.
+		if (may_redirect(_input)) {
+			auto* host = irods::replica_truncate::host_for_hierarchy(hierarchy);
+
+			if (host && LOCAL_HOST != host->localFlag) {
+				return redirect_to_owning_server(_comm, *host, _input, hierarchy, _output);
+			}
+		}
+
+		// Agents on this server which are truncating the same replica wait for one of them to do the work rather than
+		// each repeating it. A truncate to a record boundary only learns its size from the data, so it cannot share
+		// the result of a truncate to a given size.
+		std::optional<coalesced_truncate> coalesced;
+
+		if (delimiter_itr == cond_input.cend()) {
+			coalesced.emplace(fmt::format("{}#{}", _comm.clientUser.userName, _comm.clientUser.rodsZone),
+			                  _input.objPath,
+			                  target_replica->replica_number(),
+			                  _input.dataSize,
+			                  dl);
+
+			if (coalesced_truncate::role::follower == coalesced->get_role()) {
+				_output["truncated"] = coalesced->shared_truncated();
+
+				if (coalesced->shared_error_code() < 0) {
+					_output["message"] = fmt::format(
+						"Cannot truncate object [{}]: A concurrent truncate of the same replica failed.",
+						_input.objPath);
+				}
+				else if (coalesced->shared_size() != _input.dataSize) {
+					_output["message"] =
+						fmt::format("Truncate of [{}] was superseded by a concurrent truncate to size [{}].",
+					                _input.objPath,
+					                coalesced->shared_size());
+				}
+
+				return coalesced->shared_error_code();
+			}
+
+			if (const auto& size = coalesced->size_after_wait(); size) {
+				// Another agent truncated the replica while we waited, so what was read from the catalog is out of
+				// date.
+				target_replica->size(*size);
+			}
+		}
+
+		const auto ec = truncate_target_replica(_comm, _input, data_obj_info, *target_replica, dl, _deferred, _output);
+
+		if (coalesced) {
+			coalesced->complete(ec, _output.at("truncated").get<bool>());
+		}
+
+		return ec;
+	} // truncate_replica
+} // namespace irods::replica_truncate
@@ -0,0 +1,158 @@
+#include "irods/plugins/api/private/usage_ledger.hpp"
+
+#include "irods/plugins/api/private/logging.hpp"
+#include "irods/plugins/api/private/shared_memory.hpp"
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/rodsDef.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	namespace logging = irods::replica_truncate::logging;
+	namespace shm = irods::replica_truncate::shared_memory;
+
+	constexpr const char* table_name = "usage_ledger";
+	constexpr auto lock_timeout = std::chrono::seconds{5};
+
+	// One entry per resource and owner which saw a truncate since the last reset.
+	constexpr std::size_t entry_count = 4096;
+
+	// Lives in shared memory, so it must only contain trivially copyable data.
+	struct ledger_entry
+	{
+		bool in_use{};
+		std::array<char, NAME_LEN> resource{};
+		std::array<char, 2 * NAME_LEN> owner{};
+		std::int64_t bytes{};
+		std::uint64_t truncates{};
+	}; // struct ledger_entry
+
+	struct ledger_table
+	{
+		shm::mutex_type mutex;
+		std::int64_t since{};
+		std::uint64_t overflowed{};
+		std::array<ledger_entry, entry_count> entries{};
+	}; // struct ledger_table
+
+	auto now() -> std::int64_t
+	{
+		return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+		    .count();
+	} // now
+
+	auto table() -> ledger_table&
+	{
+		static auto& table = shm::find_or_construct<ledger_table>(table_name);
+		return table;
+	} // table
+
+	auto fits(std::string_view _value, std::size_t _capacity) -> bool
+	{
+		return _value.size() < _capacity;
+	} // fits
+
+	auto find_or_allocate_entry(ledger_table& _table, std::string_view _resource, std::string_view _owner)
+		-> ledger_entry*
+	{
+		auto itr = std::find_if(std::begin(_table.entries), std::end(_table.entries), [&](const auto& _e) {
+			return _e.in_use && _resource == _e.resource.data() && _owner == _e.owner.data();
+		});
+
+		if (itr != std::end(_table.entries)) {
+			return &*itr;
+		}
+
+		itr = std::find_if(
+			std::begin(_table.entries), std::end(_table.entries), [](const auto& _e) { return !_e.in_use; });
+
+		if (itr == std::end(_table.entries)) {
+			return nullptr;
+		}
+
+		*itr = ledger_entry{};
+		itr->in_use = true;
+		std::memcpy(itr->resource.data(), _resource.data(), _resource.size());
+		std::memcpy(itr->owner.data(), _owner.data(), _owner.size());
+
+		return &*itr;
+	} // find_or_allocate_entry
+} // anonymous namespace
+
+namespace irods::replica_truncate
+{
+	auto record_usage_change(std::string_view _hierarchy,
+	                         std::string_view _owner,
+	                         rodsLong_t _old_size,
+	                         rodsLong_t _new_size) noexcept -> void
+	{
+		try {
+			const auto resource = irods::replica_truncate::leaf_of(_hierarchy);
+
+			if (!fits(resource, sizeof(ledger_entry::resource)) || !fits(_owner, sizeof(ledger_entry::owner))) {
+				return;
+			}
+
+			auto& t = table();
+			auto lock = shm::lock_for(t.mutex, lock_timeout);
+			if (!lock) {
+				logging::warn(logging::category::usage,
+				              "{}: Timed out waiting for usage ledger lock. Change of [{}] bytes in [{}] not recorded.",
+				              __func__,
+				              _new_size - _old_size,
+				              resource);
+				return;
+			}
+
+			if (0 == t.since) {
+				t.since = now();
+			}
+
+			auto* entry = find_or_allocate_entry(t, resource, _owner);
+			if (!entry) {
+				++t.overflowed;
+				return;
+			}
+
+			entry->bytes += _new_size - _old_size;
+			++entry->truncates;
+		}
+		catch (const std::exception& e) {
+			logging::warn(logging::category::usage, "{}: Could not record usage change. [{}]", __func__, e.what());
+		}
+	} // record_usage_change
+
+	auto usage_ledger(bool _reset) -> nlohmann::json
+	{
+		auto& t = table();
+		auto lock = shm::lock_for(t.mutex, lock_timeout);
+		if (!lock) {
+			return nlohmann::json::object();
+		}
+
+		auto resources = nlohmann::json::object();
+
+		for (const auto& e : t.entries) {
+			if (e.in_use) {
+				resources[e.resource.data()][e.owner.data()] = {{"bytes", e.bytes}, {"truncates", e.truncates}};
+			}
+		}
+
+		auto ledger = nlohmann::json{
+			{"since", 0 == t.since ? now() : t.since}, {"overflowed", t.overflowed}, {"resources", resources}};
+
+		if (_reset) {
+			t.entries = {};
+			t.overflowed = 0;
+			t.since = now();
+		}
+
+		return ledger;
+	} // usage_ledger
+} // namespace irods::replica_truncate
@@ -0,0 +1,43 @@
+#include "irods/plugins/api/private/utilities.hpp"
+
+#include <irods/irods_resource_backport.hpp>
+#include <irods/objInfo.h>
+
+#include <fmt/format.h>
+
+namespace irods::replica_truncate
+{
+	auto root_of(std::string_view _hierarchy) noexcept -> std::string_view
+	{
+		return _hierarchy.substr(0, _hierarchy.find(';'));
+	} // root_of
+
+	auto leaf_of(std::string_view _hierarchy) noexcept -> std::string_view
+	{
+		const auto pos = _hierarchy.rfind(';');
+		return std::string_view::npos == pos ? _hierarchy : _hierarchy.substr(pos + 1);
+	} // leaf_of
+
+	auto is_at_rest(int _replica_status) noexcept -> bool
+	{
+		return GOOD_REPLICA == _replica_status || STALE_REPLICA == _replica_status;
+	} // is_at_rest
+
+	auto genquery_literal(std::string_view _value) -> std::optional<std::string>
+	{
+		if (std::string_view::npos != _value.find('\'')) {
+			return std::nullopt;
+		}
+
+		return fmt::format("'{}'", _value);
+	} // genquery_literal
+
+	auto host_of_hierarchy(std::string_view _hierarchy, std::string& _host) -> int
+	{
+		if (const auto ret = irods::get_loc_for_hier_string(std::string{_hierarchy}, _host); !ret.ok()) {
+			return static_cast<int>(ret.code());
+		}
+
+		return 0;
+	} // host_of_hierarchy
+} // namespace irods::replica_truncate
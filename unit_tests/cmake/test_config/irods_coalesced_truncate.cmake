@@ -0,0 +1,20 @@
+set(IRODS_TEST_TARGET irods_coalesced_truncate)
+
+set(IRODS_TEST_SOURCE_FILES ${CMAKE_CURRENT_SOURCE_DIR}/src/main.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/src/test_coalesced_truncate.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/coalesced_truncate.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/configuration.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/deadline.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/logging.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/shared_memory.cpp)
+
+set(IRODS_TEST_INCLUDE_PATH ${CMAKE_CURRENT_SOURCE_DIR}/../include
+                            ${IRODS_EXTERNALS_FULLPATH_BOOST}/include
+                            ${IRODS_EXTERNALS_FULLPATH_FMT}/include)
+
+set(IRODS_TEST_LINK_LIBRARIES irods_common
+                              irods_server
+                              irods_plugin_dependencies
+                              rt
+                              Threads::Threads
+                              ${IRODS_EXTERNALS_FULLPATH_FMT}/lib/libfmt.so)
@@ -0,0 +1,17 @@
+set(IRODS_TEST_TARGET irods_output_allocations)
+
+set(IRODS_TEST_SOURCE_FILES ${CMAKE_CURRENT_SOURCE_DIR}/src/main.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/src/test_output_allocations.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/configuration.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/logging.cpp
+                            ${CMAKE_CURRENT_SOURCE_DIR}/../src/output.cpp)
+
+set(IRODS_TEST_INCLUDE_PATH ${CMAKE_CURRENT_SOURCE_DIR}/../include
+                            ${IRODS_EXTERNALS_FULLPATH_BOOST}/include
+                            ${IRODS_EXTERNALS_FULLPATH_FMT}/include)
+
+set(IRODS_TEST_LINK_LIBRARIES irods_common
+                              irods_server
+                              irods_plugin_dependencies
+                              Threads::Threads
+                              ${IRODS_EXTERNALS_FULLPATH_FMT}/lib/libfmt.so)
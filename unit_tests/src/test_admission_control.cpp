@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include "irods/plugins/api/private/admission_control.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+#include "irods/plugins/api/private/shared_memory.hpp"
+
+#include "irods/irods_configuration_keywords.hpp"
+#include "irods/irods_server_properties.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <new>
+#include <string>
+
+// The agents are simulated with child processes. A child never returns into Catch2. It reports through its exit
+// status instead.
+
+// clang-format off
+namespace shm = irods::replica_truncate::shared_memory;
+
+using irods::replica_truncate::admission_permit;
+using irods::replica_truncate::deadline;
+using irods::replica_truncate::priority;
+// clang-format on
+
+namespace
+{
+	constexpr const char* resource = "test_admission_control_resc";
+	constexpr const char* hierarchy = "test_admission_control_root;test_admission_control_resc";
+
+	// The plugin reads its configuration once, so every test case sets the same one.
+	auto configure_limits() -> void
+	{
+		const auto config = nlohmann::json{
+			{"admission_control",
+		     {{"max_wait_in_seconds", 1}, {"resources", {{resource, {{"max_concurrent", 1}}}}}}}};
+
+		irods::set_server_property(irods::KW_CFG_PLUGIN_CONFIGURATION,
+		                           nlohmann::json{{"api", {{"irods_api_plugin_replica_truncate", config}}}});
+	} // configure_limits
+
+	auto wait_for_child(pid_t _pid) -> int
+	{
+		int status{};
+		waitpid(_pid, &status, 0);
+		return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	} // wait_for_child
+} // anonymous namespace
+
+TEST_CASE("robust_mutex is recovered when its holder is killed")
+{
+	auto* memory = mmap(nullptr, sizeof(shm::robust_mutex), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	REQUIRE(MAP_FAILED != memory);
+
+	auto* mutex = new (memory) shm::robust_mutex;
+
+	const auto child = fork();
+	REQUIRE(child >= 0);
+
+	if (0 == child) {
+		mutex->lock();
+		raise(SIGKILL);
+		_exit(0);
+	}
+
+	int status{};
+	waitpid(child, &status, 0);
+	REQUIRE(WIFSIGNALED(status));
+
+	{
+		auto lock = shm::lock_for(*mutex, std::chrono::seconds{1});
+		CHECK(lock.owns());
+	}
+
+	// Once recovered, the mutex works as before.
+	{
+		auto lock = shm::lock_for(*mutex, std::chrono::seconds{1});
+		CHECK(lock.owns());
+	}
+
+	mutex->~robust_mutex();
+	munmap(memory, sizeof(shm::robust_mutex));
+}
+
+TEST_CASE("admission_permit rejects requests once the maximum wait elapses")
+{
+	configure_limits();
+
+	admission_permit first{hierarchy, priority::interactive, deadline{}};
+	REQUIRE(first.admitted());
+	CHECK(resource == first.resource());
+
+	{
+		admission_permit second{hierarchy, priority::interactive, deadline{}};
+		CHECK_FALSE(second.admitted());
+		CHECK(second.queue_delay() >= std::chrono::milliseconds{900});
+	}
+
+	const auto stats = irods::replica_truncate::admission_statistics();
+	CHECK(stats.at(resource).at("lanes").at("interactive").at("timed_out").get<int>() >= 1);
+}
+
+TEST_CASE("admission_permit is not held up by an agent which was killed while admitted")
+{
+	configure_limits();
+
+	int ready[2]{};
+	REQUIRE(0 == pipe(ready));
+
+	const auto child = fork();
+	REQUIRE(child >= 0);
+
+	if (0 == child) {
+		close(ready[0]);
+
+		admission_permit permit{hierarchy, priority::interactive, deadline{}};
+		const char admitted = permit.admitted() ? 1 : 0;
+		if (1 != write(ready[1], &admitted, 1)) {
+			_exit(2);
+		}
+
+		raise(SIGKILL);
+		_exit(0);
+	}
+
+	close(ready[1]);
+
+	char admitted{};
+	REQUIRE(1 == read(ready[0], &admitted, 1));
+	close(ready[0]);
+	REQUIRE(1 == admitted);
+
+	wait_for_child(child);
+
+	admission_permit permit{hierarchy, priority::interactive, deadline{}};
+	CHECK(permit.admitted());
+}
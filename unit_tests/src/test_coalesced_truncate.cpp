@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+
+#include "irods/plugins/api/private/coalesced_truncate.hpp"
+#include "irods/plugins/api/private/deadline.hpp"
+
+#include <fmt/format.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+// The agents are simulated with child processes. A child never returns into Catch2. It reports through its exit
+// status instead.
+
+using irods::replica_truncate::coalesced_truncate;
+using irods::replica_truncate::deadline;
+using role = coalesced_truncate::role;
+
+namespace
+{
+	constexpr const char* user = "test_coalesced_truncate";
+
+	// The shared table outlives the test, so every run uses its own paths.
+	auto unique_path(const char* _name) -> std::string
+	{
+		return fmt::format("/tempZone/home/{}/{}.{}", user, _name, getpid());
+	} // unique_path
+
+	auto wait_for_child(pid_t _pid) -> int
+	{
+		int status{};
+		waitpid(_pid, &status, 0);
+		return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	} // wait_for_child
+} // anonymous namespace
+
+TEST_CASE("coalesced_truncate follower receives the result of the leader")
+{
+	const auto path = unique_path("follower");
+
+	int ready[2]{};
+	REQUIRE(0 == pipe(ready));
+
+	const auto child = fork();
+	REQUIRE(child >= 0);
+
+	if (0 == child) {
+		close(ready[0]);
+
+		coalesced_truncate leader{user, path, 0, 4, deadline{}};
+		const char led = role::leader == leader.get_role() ? 1 : 0;
+		if (1 != write(ready[1], &led, 1)) {
+			_exit(2);
+		}
+
+		// Give the parent time to join as a follower before the result is published.
+		std::this_thread::sleep_for(std::chrono::milliseconds{500});
+		leader.complete(0, true);
+
+		_exit(0);
+	}
+
+	close(ready[1]);
+
+	char led{};
+	REQUIRE(1 == read(ready[0], &led, 1));
+	close(ready[0]);
+	REQUIRE(1 == led);
+
+	coalesced_truncate follower{user, path, 0, 4, deadline{}};
+	CHECK(role::follower == follower.get_role());
+	CHECK(0 == follower.shared_error_code());
+	CHECK(follower.shared_truncated());
+	CHECK(4 == follower.shared_size());
+
+	CHECK(0 == wait_for_child(child));
+}
+
+TEST_CASE("coalesced_truncate does not wait on a leader which exited without a result")
+{
+	const auto path = unique_path("dead_leader");
+
+	const auto child = fork();
+	REQUIRE(child >= 0);
+
+	if (0 == child) {
+		coalesced_truncate leader{user, path, 0, 4, deadline{}};
+		_exit(role::leader == leader.get_role() ? 0 : 1);
+	}
+
+	REQUIRE(0 == wait_for_child(child));
+
+	const auto start = std::chrono::steady_clock::now();
+
+	{
+		coalesced_truncate request{user, path, 0, 4, deadline{}};
+		CHECK(role::uncoordinated == request.get_role());
+	}
+
+	// Far less than the time a follower waits for a live leader.
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds{5});
+
+	// The abandoned slot is reclaimed, so the next request leads again.
+	coalesced_truncate request{user, path, 0, 4, deadline{}};
+	CHECK(role::leader == request.get_role());
+	request.complete(0, true);
+}
+
+TEST_CASE("coalesced_truncate leads again after completing")
+{
+	const auto path = unique_path("same_agent");
+
+	for (int i = 0; i < 2; ++i) {
+		coalesced_truncate request{user, path, 0, 4 - i, deadline{}};
+		REQUIRE(role::leader == request.get_role());
+		request.complete(0, true);
+	}
+}
@@ -0,0 +1,154 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/resource_administration.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/rodsKeyWdDef.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace adm     = irods::experimental::administration;
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+// Truncating both tiers in place is opt-in on the server, so each tier may report either outcome. The catalog must
+// agree with the reported outcome either way.
+TEST_CASE("compound_resource_tiers_are_reported")
+{
+	try {
+		load_client_api_plugins();
+
+		const std::string compound_resc = "test_compound_tiers_resc";
+		const std::string cache_resc = "test_compound_tiers_cache";
+		const std::string archive_resc = "test_compound_tiers_archive";
+
+		{
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			adm::resource_registration_info compound_info;
+			compound_info.resource_name = compound_resc;
+			compound_info.resource_type = adm::resource_type::compound;
+			adm::client::add_resource(comm, compound_info);
+
+			unit_test_utils::add_ufs_resource(comm, cache_resc, cache_resc + "_vault");
+			unit_test_utils::add_ufs_resource(comm, archive_resc, archive_resc + "_vault");
+
+			adm::client::add_child_resource(comm, compound_resc, cache_resc, "cache");
+			adm::client::add_child_resource(comm, compound_resc, archive_resc, "archive");
+		}
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_compound_tiers";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox, &compound_resc, &cache_resc, &archive_resc] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+
+			adm::client::remove_child_resource(comm, compound_resc, cache_resc);
+			adm::client::remove_child_resource(comm, compound_resc, archive_resc);
+			adm::client::remove_resource(comm, cache_resc);
+			adm::client::remove_resource(comm, archive_resc);
+			adm::client::remove_resource(comm, compound_resc);
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		// The compound resource copies the new cache replica to the archive when it is closed.
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object, io::root_resource_name{compound_resc}} << contents;
+		}
+
+		const auto cache_hierarchy = fmt::format("{};{}", compound_resc, cache_resc);
+		const auto archive_hierarchy = fmt::format("{};{}", compound_resc, archive_resc);
+
+		REQUIRE(GOOD_REPLICA == replica::replica_status(comm, target_object, 0));
+		REQUIRE(GOOD_REPLICA == replica::replica_status(comm, target_object, 1));
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+
+		SECTION("cache replica")
+		{
+			addKeyVal(&input.condInput, RESC_HIER_STR_KW, cache_hierarchy.c_str());
+
+			nlohmann::json output;
+			REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+
+			const auto& tiers = output.at("tiers");
+			CHECK("truncated" == tiers.at("cache").get<std::string>());
+
+			// Either way, the archive ends up with the truncated data.
+			const auto archive = tiers.at("archive").get<std::string>();
+			CHECK(("truncated" == archive || "replicated" == archive));
+
+			for (const auto replica_number : {0, 1}) {
+				CHECK(GOOD_REPLICA == replica::replica_status(comm, target_object, replica_number));
+				CHECK(4 == replica::replica_size(comm, target_object, replica_number));
+			}
+		}
+
+		SECTION("archive replica")
+		{
+			addKeyVal(&input.condInput, RESC_HIER_STR_KW, archive_hierarchy.c_str());
+
+			nlohmann::json output;
+			REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+
+			const auto& tiers = output.at("tiers");
+			CHECK("truncated" == tiers.at("archive").get<std::string>());
+			CHECK(4 == replica::replica_size(comm, target_object, 1));
+			CHECK(GOOD_REPLICA == replica::replica_status(comm, target_object, 1));
+
+			// The compound resource does not copy a modified archive replica to the cache.
+			const auto cache = tiers.at("cache").get<std::string>();
+			if ("truncated" == cache) {
+				CHECK(GOOD_REPLICA == replica::replica_status(comm, target_object, 0));
+				CHECK(4 == replica::replica_size(comm, target_object, 0));
+			}
+			else {
+				CHECK("stale" == cache);
+				CHECK(STALE_REPLICA == replica::replica_status(comm, target_object, 0));
+			}
+		}
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // compound_resource_tiers_are_reported
@@ -0,0 +1,113 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/resource_administration.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace adm     = irods::experimental::administration;
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("allow_copy_leaves_native_truncate_alone")
+{
+	try {
+		load_client_api_plugins();
+
+		const std::string resource = "test_copy_truncate_resc";
+		const auto vault = unit_test_utils::create_resource_vault(resource + "_vault");
+
+		{
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			adm::resource_registration_info ufs_info;
+			ufs_info.resource_name = resource;
+			ufs_info.resource_type = adm::resource_type::unixfilesystem;
+			ufs_info.host_name = unit_test_utils::get_hostname();
+			ufs_info.vault_path = vault;
+
+			adm::client::add_resource(comm, ufs_info);
+		}
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_copy_truncate";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox, &resource] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+
+			adm::client::remove_resource(comm, resource);
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object, io::root_resource_name{resource}} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+		addKeyVal(&input.condInput, TRUNCATE_ALLOW_COPY_KW, "");
+
+		nlohmann::json output;
+		REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+		CHECK(output.at("truncated").get<bool>());
+		CHECK(4 == replica::replica_size(comm, target_object, 0));
+
+		// A unixfilesystem resource truncates natively, so the copy fallback must not have left a file next to the
+		// replica's data.
+		int files = 0;
+		for (const auto& e : boost::filesystem::recursive_directory_iterator{vault}) {
+			if (boost::filesystem::is_regular_file(e.path())) {
+				++files;
+				CHECK(std::string::npos == e.path().filename().string().find(".truncate."));
+				CHECK(4 == boost::filesystem::file_size(e.path()));
+			}
+		}
+
+		CHECK(1 == files);
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // allow_copy_leaves_native_truncate_alone
@@ -0,0 +1,176 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/rodsErrorTable.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// clang-format off
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("snapshot_keeps_the_original_data")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_data_snapshot";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+
+		SECTION("snapshot keeps the original data")
+		{
+			addKeyVal(&input.condInput, TRUNCATE_SNAPSHOT_KW, "clone_or_copy");
+
+			nlohmann::json output;
+			REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+			CHECK(4 == replica::replica_size(comm, target_object, 0));
+
+			const auto snapshot = fs::path{output.at("snapshot").at("logical_path").get<std::string>()};
+			REQUIRE(fs::client::exists(comm, snapshot));
+			CHECK(contents.size() == replica::replica_size(comm, snapshot, 0));
+		}
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // snapshot_keeps_the_original_data
+
+TEST_CASE("snapshot_of_a_non_admin_client")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const std::string user_name = "test_data_snapshot_user";
+		const std::string password = "rods";
+		unit_test_utils::add_rodsuser(comm, user_name, password);
+
+		const auto user_home = fs::path{"/"} / env.rodsZone / "home" / user_name;
+		const auto target_object = user_home / "target_object";
+
+		auto* user_comm = unit_test_utils::connect_as(user_name, password);
+		REQUIRE(user_comm);
+
+		irods::at_scope_exit remove_user{[user_comm, &user_home, &user_name] {
+			// Collect the paths first, since removing data objects changes what the iterator would see.
+			std::vector<fs::path> objects;
+			for (const auto& e : fs::client::collection_iterator{*user_comm, user_home}) {
+				objects.push_back(e.path());
+			}
+
+			for (const auto& p : objects) {
+				fs::client::remove(*user_comm, p, fs::remove_options::no_trash);
+			}
+
+			rcDisconnect(user_comm);
+
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			unit_test_utils::remove_user(comm, user_name);
+		}};
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		{
+			io::client::native_transport tp{*user_comm};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+		addKeyVal(&input.condInput, TRUNCATE_SNAPSHOT_KW, "clone_or_copy");
+
+		// Registering a file in a vault requires rodsadmin, which the client does not have.
+		nlohmann::json output;
+		REQUIRE(0 == unit_test_utils::replica_truncate(*user_comm, input, output));
+		CHECK(4 == replica::replica_size(*user_comm, target_object, 0));
+
+		// The snapshot belongs to the client, who can read it and remove it like any other data object.
+		const auto snapshot = fs::path{output.at("snapshot").at("logical_path").get<std::string>()};
+		REQUIRE(fs::client::exists(*user_comm, snapshot));
+		CHECK(contents.size() == replica::replica_size(*user_comm, snapshot, 0));
+
+		std::string data;
+		{
+			io::client::native_transport tp{*user_comm};
+			io::idstream{tp, snapshot} >> data;
+		}
+		CHECK(contents == data);
+
+		// The snapshot's file has the permissions of the replica's file.
+		const auto snapshot_file = output.at("snapshot").at("physical_path").get<std::string>();
+		const auto original_file = snapshot_file.substr(0, snapshot_file.rfind(".snapshot."));
+		CHECK(boost::filesystem::status(original_file).permissions() ==
+		      boost::filesystem::status(snapshot_file).permissions());
+
+		CHECK_NOTHROW(fs::client::remove(*user_comm, snapshot, fs::remove_options::no_trash));
+		CHECK_FALSE(fs::client::exists(*user_comm, snapshot));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // snapshot_of_a_non_admin_client
@@ -0,0 +1,80 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("expired_deadline_leaves_the_replica_alone")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_deadline";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+
+		// One millisecond after the Unix epoch.
+		addKeyVal(&input.condInput, TRUNCATE_DEADLINE_KW, "1");
+
+		nlohmann::json output;
+		CHECK(REPLICA_TRUNCATE_DEADLINE_EXCEEDED == unit_test_utils::replica_truncate(comm, input, output));
+		CHECK(output.at("deadline_exceeded").get<bool>());
+		CHECK(contents.size() == replica::replica_size(comm, target_object, 0));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // expired_deadline_leaves_the_replica_alone
@@ -0,0 +1,125 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/rodsErrorTable.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("request_ids_replay_results")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_idempotent_request";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+
+		// Request IDs are remembered by the server across test runs, so each run uses its own.
+		const auto request_id = fmt::format(
+			"test_idempotent_request_{}", std::chrono::system_clock::now().time_since_epoch().count());
+		addKeyVal(&input.condInput, TRUNCATE_REQUEST_ID_KW, request_id.c_str());
+
+		SECTION("replayed request does not run again")
+		{
+			nlohmann::json output;
+			REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+			CHECK_FALSE(output.contains("replayed"));
+			REQUIRE(4 == replica::replica_size(comm, target_object, 0));
+
+			// Restore the data so that the replay can be told apart from running the request again.
+			{
+				io::client::native_transport tp{conn};
+				io::odstream{tp, target_object} << contents;
+			}
+
+			output.clear();
+			REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+			CHECK(output.at("replayed").get<bool>());
+			CHECK(contents.size() == replica::replica_size(comm, target_object, 0));
+
+			// The same ID with a different request is rejected rather than replaying the wrong result.
+			input.dataSize = 2;
+			output.clear();
+			CHECK(SYS_INVALID_INPUT_PARAM == unit_test_utils::replica_truncate(comm, input, output));
+			CHECK(contents.size() == replica::replica_size(comm, target_object, 0));
+		}
+
+		SECTION("request which failed before truncating the data runs again")
+		{
+			const auto later_object = sandbox / "later_object";
+			std::strncpy(input.objPath, later_object.c_str(), MAX_NAME_LEN - 1);
+
+			nlohmann::json output;
+			REQUIRE(unit_test_utils::replica_truncate(comm, input, output) < 0);
+			CHECK_FALSE(output.contains("data_truncated"));
+
+			{
+				io::client::native_transport tp{conn};
+				io::odstream{tp, later_object} << contents;
+			}
+
+			output.clear();
+			REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+			CHECK_FALSE(output.contains("replayed"));
+			CHECK(output.at("data_truncated").get<bool>());
+			CHECK(4 == replica::replica_size(comm, later_object, 0));
+		}
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // request_ids_replay_results
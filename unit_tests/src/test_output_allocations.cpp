@@ -0,0 +1,180 @@
+#include <catch2/catch.hpp>
+
+#include "irods/plugins/api/private/output.hpp"
+
+#include "irods/rodsDef.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// Counts every allocation made through operator new, which covers std::string, nlohmann::json's serializer, and any
+// spill of the serialization buffer into the heap. The mallocs handed to the API framework are not counted.
+namespace
+{
+	std::size_t allocations = 0;
+	std::size_t allocated_bytes = 0;
+} // anonymous namespace
+
+auto operator new(std::size_t _size) -> void*
+{
+	++allocations;
+	allocated_bytes += _size;
+
+	if (auto* p = std::malloc(_size == 0 ? 1 : _size); p) {
+		return p;
+	}
+
+	throw std::bad_alloc{};
+}
+
+auto operator delete(void* _p) noexcept -> void
+{
+	std::free(_p);
+}
+
+auto operator delete(void* _p, std::size_t) noexcept -> void
+{
+	std::free(_p);
+}
+
+namespace
+{
+	auto free_output(BytesBuf* _output) -> void
+	{
+		std::free(_output->buf);
+		std::free(_output);
+	} // free_output
+
+	auto typical_output() -> nlohmann::json
+	{
+		return {{"message", ""},
+		        {"truncated", true},
+		        {"replica_number", 0},
+		        {"resource_hierarchy", "root_resource;passthru_resource;unixfilesystem_resource"}};
+	} // typical_output
+
+	// What make_output_struct used to do.
+	auto make_output_struct_with_dump(nlohmann::json _output) -> BytesBuf*
+	{
+		const auto json_str = _output.dump();
+
+		auto* output = static_cast<BytesBuf*>(std::malloc(sizeof(BytesBuf)));
+		output->buf = strdup(json_str.c_str());
+		output->len = static_cast<int>(std::strlen(json_str.c_str()) + 1);
+
+		return output;
+	} // make_output_struct_with_dump
+
+	// Lets the serializer run without keeping its output, to measure what nlohmann::json allocates on its own.
+	class discarding_buffer : public std::streambuf
+	{
+	  protected:
+		auto overflow(int_type _c) -> int_type override
+		{
+			return traits_type::not_eof(_c);
+		} // overflow
+
+		auto xsputn(const char_type*, std::streamsize _n) -> std::streamsize override
+		{
+			return _n;
+		} // xsputn
+	}; // class discarding_buffer
+
+	struct heap_usage
+	{
+		double allocations;
+		double bytes;
+	}; // struct heap_usage
+
+	template <typename Function>
+	auto measure_per_request(Function _serialize) -> heap_usage
+	{
+		constexpr int iterations = 1000;
+
+		// The JSON is built by the request, not by serialization, so it is excluded from the count.
+		std::size_t total_allocations = 0;
+		std::size_t total_bytes = 0;
+		for (int i = 0; i < iterations; ++i) {
+			auto output = typical_output();
+
+			const auto allocations_before = allocations;
+			const auto bytes_before = allocated_bytes;
+			_serialize(std::move(output));
+			total_allocations += allocations - allocations_before;
+			total_bytes += allocated_bytes - bytes_before;
+		}
+
+		return {static_cast<double>(total_allocations) / iterations, static_cast<double>(total_bytes) / iterations};
+	} // measure_per_request
+} // anonymous namespace
+
+TEST_CASE("make_output_struct only allocates what nlohmann::json's serializer does")
+{
+	// Initializes the plugin configuration and logging state, which happens once per agent.
+	free_output(irods::replica_truncate::make_output_struct(typical_output()));
+
+	const auto serializer = measure_per_request([](nlohmann::json _output) {
+		discarding_buffer discard;
+		std::ostream os{&discard};
+		os << _output;
+	});
+
+	const auto with_dump = measure_per_request(
+		[](nlohmann::json _output) { free_output(make_output_struct_with_dump(std::move(_output))); });
+
+	const auto with_buffer = measure_per_request(
+		[](nlohmann::json _output) { free_output(irods::replica_truncate::make_output_struct(std::move(_output))); });
+
+	WARN("heap allocations per request (bytes): serializer alone = "
+	     << serializer.allocations << " (" << serializer.bytes << "), dump = " << with_dump.allocations << " ("
+	     << with_dump.bytes << "), static buffer = " << with_buffer.allocations << " (" << with_buffer.bytes << ")");
+
+	// The serialized text is written to the static buffer, so it adds no allocations of its own. What is left is
+	// the output adapter and indentation buffer of nlohmann::json, which no caller can avoid.
+	CHECK(with_buffer.allocations == serializer.allocations);
+	CHECK(with_buffer.bytes == serializer.bytes);
+}
+
+TEST_CASE("make_output_struct serializes output larger than its buffer")
+{
+	auto output = typical_output();
+	output["message"] = std::string(64 * 1024, 'x');
+
+	auto* expected = make_output_struct_with_dump(output);
+	auto* actual = irods::replica_truncate::make_output_struct(output);
+
+	CHECK(expected->len == actual->len);
+	CHECK(std::string{static_cast<char*>(expected->buf)} == std::string{static_cast<char*>(actual->buf)});
+
+	free_output(expected);
+	free_output(actual);
+}
+
+TEST_CASE("make_output_struct output is unchanged")
+{
+	auto* expected = make_output_struct_with_dump(typical_output());
+	auto* actual = irods::replica_truncate::make_output_struct(typical_output());
+
+	CHECK(expected->len == actual->len);
+	CHECK(std::string{static_cast<char*>(expected->buf)} == std::string{static_cast<char*>(actual->buf)});
+
+	free_output(expected);
+	free_output(actual);
+}
+
+TEST_CASE("make_output_struct always includes a message")
+{
+	auto* output = irods::replica_truncate::make_output_struct({{"truncated", false}});
+
+	const auto json = nlohmann::json::parse(static_cast<char*>(output->buf));
+	CHECK(json.at("message") == "");
+
+	free_output(output);
+}
@@ -8,6 +8,7 @@
 #include "irods/irods_exception.hpp"
 #include "irods/key_value_proxy.hpp"
 #include "irods/objInfo.h"
+#include "irods/plugins/api/rc_replica_truncate.h"
 #include "irods/rcMisc.h"
 #include "irods/replica.hpp"
 #include "irods/replica_proxy.hpp"
@@ -20,6 +21,7 @@
 
 #include <fmt/format.h>
 
+#include <cstdio>
 #include <cstring>
 #include <string>
 #include <string_view>
@@ -109,31 +111,29 @@ TEST_CASE("truncate_locked_data_object__issue_7104")
 				irods::experimental::client_connection conn2;
 				RcComm& comm2 = static_cast<RcComm&>(conn2);
 
-				auto input = nlohmann::json{{"path", target_object.c_str()}};
+				DataObjInp input{};
+				irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+				std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
 
 				SECTION("same size")
 				{
-					input["length"] = contents.size();
+					input.dataSize = static_cast<rodsLong_t>(contents.size());
 				}
 
 				SECTION("larger size")
 				{
-					input["length"] = contents.size() + 1;
+					input.dataSize = static_cast<rodsLong_t>(contents.size() + 1);
 				}
 
 				SECTION("smaller size")
 				{
-					input["length"] = contents.size() - 1;
+					input.dataSize = static_cast<rodsLong_t>(contents.size() - 1);
 				}
 
-				char* output_str;
-				const auto free_output_str = irods::at_scope_exit{[&output_str] { std::free(output_str); }};
-
 				// Attempt to truncate the object using the size specified for each section, and fail.
-				CHECK(-1 == rc_replica_truncate(&comm2, &input.dump().c_str(), &output_str));
-
-				const auto output = nlohmann::json::parse(output_str);
-				CHECK(LOCKED_DATA_OBJECT_ACCESS == output.at("error_code"));
+				nlohmann::json output;
+				CHECK(LOCKED_DATA_OBJECT_ACCESS == unit_test_utils::replica_truncate(comm2, input, output));
+				CHECK(std::string::npos != output.at("message").get<std::string>().find("Object is not at rest."));
 
 				// Object will close at this scope exit.
 			}
@@ -159,71 +159,30 @@ TEST_CASE("invalid_inputs")
 	irods::experimental::client_connection conn;
 	RcComm& comm = static_cast<RcComm&>(conn);
 
-	rodsEnv env;
-	_getRodsEnv(env);
-
-	char* output_str;
-	const auto free_output_str = irods::at_scope_exit{[&output_str] { std::free(output_str); }};
-
 	try {
 		SECTION("nullptr_input_and_output")
 		{
-			CHECK(USER__NULL_INPUT_ERR == rc_replica_truncate(&comm, nullptr, &output_str));
-			CHECK(USER__NULL_INPUT_ERR == rc_replica_truncate(&comm, "", nullptr));
-		}
-
-		SECTION("empty_string")
-		{
-			CHECK(JSON_VALIDATION_ERROR == rc_replica_truncate(comm, "", &output_str));
+			DataObjInp input{};
+			BytesBuf* output{};
 
-			const auto output = nlohmann::json::parse(output_str);
-			CHECK(std::string::npos != output.at("message").find("Failed to parse input to JSON."));
+			CHECK(USER__NULL_INPUT_ERR == rc_replica_truncate(&comm, nullptr, &output));
+			CHECK(USER__NULL_INPUT_ERR == rc_replica_truncate(&comm, &input, nullptr));
 		}
 
-		SECTION("non_empty_non_json")
+		SECTION("replica_number_and_resource_are_incompatible")
 		{
-			CHECK(JSON_VALIDATION_ERROR == rc_replica_truncate(comm, "this results in an error", &output_str));
-
-			const auto output = nlohmann::json::parse(output_str);
-			CHECK(std::string::npos != output.at("message").find("Failed to parse input to JSON."));
-		}
-
-		SECTION("empty_json_list")
-		{
-			CHECK(JSON_VALIDATION_ERROR ==
-			      rc_replica_truncate(comm, nlohmann::json::array{}.dump().c_str(), &output_str));
-
-			const auto output = nlohmann::json::parse(output_str);
-			CHECK(std::string::npos != output.at("message").find("Expected input to be a JSON object."));
-		}
-
-		SECTION("json_list_input_with_expected_values")
-		{
-			CHECK(JSON_VALIDATION_ERROR ==
-			      rc_replica_truncate(comm, nlohmann::json::array{{"path", "length"}}.dump().c_str(), &output_str));
-
-			const auto output = nlohmann::json::parse(output_str);
-			CHECK(std::string::npos != output.at("message").find("Expected input to be a JSON object."));
-		}
-
-		SECTION("empty_json")
-		{
-			CHECK(JSON_VALIDATION_ERROR == rc_replica_truncate(comm, nlohmann::json{}.dump().c_str(), &output_str));
-
-			const auto output = nlohmann::json::parse(output_str);
-			CHECK(std::string::npos != output.at("message").find("Input is missing 'path' key."));
-		}
-
-		SECTION("expected_json_structure_with_wrong_types")
-		{
-			constexpr nlohmann::json null;
-			REQUIRE(null.is_null());
-
-			const auto input = nlohmann::json{{"path", null}, {"length", null}};
-			CHECK(JSON_VALIDATION_ERROR == rc_replica_truncate(comm, input.dump().c_str(), &output_str));
-
-			const auto output = nlohmann::json::parse(output_str);
-			CHECK(std::string::npos != output.at("message").find("Input is missing 'path' key."));
+			rodsEnv env;
+			_getRodsEnv(env);
+
+			DataObjInp input{};
+			irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+			std::snprintf(input.objPath, sizeof(input.objPath), "%s/does_not_matter", env.rodsHome);
+			addKeyVal(&input.condInput, REPL_NUM_KW, "0");
+			addKeyVal(&input.condInput, RESC_NAME_KW, "demoResc");
+
+			nlohmann::json output;
+			CHECK(USER_INCOMPATIBLE_PARAMS == unit_test_utils::replica_truncate(comm, input, output));
+			CHECK(std::string::npos != output.at("message").get<std::string>().find("incompatible options"));
 		}
 	}
 	catch (...) {
@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("truncate_to_delimiter_keeps_whole_records")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_record_boundary";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		// The last record has no delimiter, so it is never kept whole.
+		std::string contents = "a\nbb\nccc";
+		rodsLong_t max_size{};
+		rodsLong_t expected_size{};
+
+		SECTION("maximum inside of a record")
+		{
+			max_size = 7;
+			expected_size = 5;
+		}
+
+		SECTION("maximum just after a delimiter")
+		{
+			max_size = 5;
+			expected_size = 5;
+		}
+
+		SECTION("maximum beyond the end of the data")
+		{
+			max_size = 100;
+			expected_size = 5;
+		}
+
+		SECTION("maximum inside of the first record")
+		{
+			max_size = 1;
+			expected_size = 0;
+		}
+
+		SECTION("no delimiter in the data")
+		{
+			contents = "abc";
+			max_size = 2;
+			expected_size = 0;
+		}
+
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = max_size;
+		addKeyVal(&input.condInput, TRUNCATE_TO_DELIMITER_KW, "\n");
+
+		nlohmann::json output;
+		REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+		CHECK(expected_size == output.at("size").get<rodsLong_t>());
+		CHECK(expected_size == replica::replica_size(comm, target_object, 0));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // truncate_to_delimiter_keeps_whole_records
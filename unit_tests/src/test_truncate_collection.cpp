@@ -0,0 +1,244 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/resource_administration.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace adm     = irods::experimental::administration;
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("collection_prefix_matches_whole_path_segments")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_truncate_collection_prefix";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		// '_' is a wildcard in a LIKE pattern, so a query for "a_b" also finds "axb". "a_bc" only shares the prefix.
+		const auto target = sandbox / "a_b";
+		const auto nested = target / "nested";
+		const auto similar = sandbox / "axb";
+		const auto longer = sandbox / "a_bc";
+
+		for (const auto& collection : {target, nested, similar, longer}) {
+			REQUIRE(fs::client::create_collection(comm, collection));
+		}
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		for (const auto& collection : {target, nested, similar, longer}) {
+			io::client::native_transport tp{conn};
+			io::odstream{tp, collection / "data_object"} << contents;
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+		addKeyVal(&input.condInput, TRUNCATE_COLLECTION_KW, "");
+
+		nlohmann::json output;
+		REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+		CHECK(2 == output.at("summary").at("matched").get<int>());
+		CHECK(2 == output.at("summary").at("truncated").get<int>());
+
+		CHECK(4 == replica::replica_size(comm, target / "data_object", 0));
+		CHECK(4 == replica::replica_size(comm, nested / "data_object", 0));
+		CHECK(contents.size() == replica::replica_size(comm, similar / "data_object", 0));
+		CHECK(contents.size() == replica::replica_size(comm, longer / "data_object", 0));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // collection_prefix_matches_whole_path_segments
+
+TEST_CASE("deferred_notifications_synchronize_replication_resource")
+{
+	try {
+		load_client_api_plugins();
+
+		const std::string repl_resc = "test_truncate_collection_repl";
+		const std::string first_child = "test_truncate_collection_repl_0";
+		const std::string second_child = "test_truncate_collection_repl_1";
+
+		{
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+			unit_test_utils::add_replication_resource(comm, repl_resc, first_child, second_child);
+		}
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_truncate_collection_repl";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox, &repl_resc, &first_child, &second_child] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+
+			adm::client::remove_child_resource(comm, repl_resc, first_child);
+			adm::client::remove_child_resource(comm, repl_resc, second_child);
+			adm::client::remove_resource(comm, first_child);
+			adm::client::remove_resource(comm, second_child);
+			adm::client::remove_resource(comm, repl_resc);
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		// The replication resource makes a replica in each child when the data object is created.
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object, io::root_resource_name{repl_resc}} << contents;
+		}
+
+		REQUIRE(GOOD_REPLICA == replica::replica_status(comm, target_object, 0));
+		REQUIRE(GOOD_REPLICA == replica::replica_status(comm, target_object, 1));
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, sandbox.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+		addKeyVal(&input.condInput, TRUNCATE_COLLECTION_KW, "");
+		addKeyVal(&input.condInput, TRUNCATE_DEFER_NOTIFICATIONS_KW, "");
+		addKeyVal(&input.condInput, RESC_NAME_KW, repl_resc.c_str());
+
+		nlohmann::json output;
+		REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+		CHECK(1 == output.at("summary").at("truncated").get<int>());
+		CHECK(1 == output.at("notifications").at("delivered").get<int>());
+
+		// The replication resource only brings the other replica up to date if the notification says that the
+		// truncated replica was written.
+		for (const auto replica_number : {0, 1}) {
+			CHECK(GOOD_REPLICA == replica::replica_status(comm, target_object, replica_number));
+			CHECK(4 == replica::replica_size(comm, target_object, replica_number));
+		}
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // deferred_notifications_synchronize_replication_resource
+
+TEST_CASE("deferred_notifications_count_each_replica_once")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_truncate_collection_deferred";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		const auto first_object = sandbox / "first_object";
+		const auto second_object = sandbox / "second_object";
+
+		for (const auto& path : {first_object, second_object}) {
+			io::client::native_transport tp{conn};
+			io::odstream{tp, path} << contents;
+		}
+
+		// The first object is truncated twice, but it only has one replica to notify about.
+		const auto manifest = sandbox / "manifest.jsonl";
+		{
+			io::client::native_transport tp{conn};
+			io::odstream out{tp, manifest};
+			out << fmt::format(R"({{"path": "{}", "size": 6}})", first_object.c_str()) << '\n'
+				<< fmt::format(R"({{"path": "{}", "size": 4}})", first_object.c_str()) << '\n'
+				<< fmt::format(R"({{"path": "{}", "size": 4}})", second_object.c_str()) << '\n';
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, manifest.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = -1;
+		addKeyVal(&input.condInput, TRUNCATE_MANIFEST_KW, "");
+		addKeyVal(&input.condInput, TRUNCATE_DEFER_NOTIFICATIONS_KW, "");
+
+		nlohmann::json output;
+		REQUIRE(0 == unit_test_utils::replica_truncate(comm, input, output));
+		CHECK(3 == output.at("summary").at("truncated").get<int>());
+
+		const auto& notifications = output.at("notifications");
+		CHECK(2 == notifications.at("deferred").get<int>());
+		CHECK(2 == notifications.at("delivered").get<int>());
+		CHECK(0 == notifications.at("failed").get<int>());
+
+		CHECK(4 == replica::replica_size(comm, first_object, 0));
+		CHECK(4 == replica::replica_size(comm, second_object, 0));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // deferred_notifications_count_each_replica_once
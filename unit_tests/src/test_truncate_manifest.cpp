@@ -0,0 +1,190 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/rodsErrorTable.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// clang-format off
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("manifest_lines_which_cannot_be_used_are_reported_and_skipped")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_truncate_manifest";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		const auto first_object = sandbox / "first_object";
+		const auto second_object = sandbox / "second_object";
+
+		for (const auto& path : {first_object, second_object}) {
+			io::client::native_transport tp{conn};
+			io::odstream{tp, path} << contents;
+		}
+
+		// Lines are limited to 64 KiB, so that one bad line cannot make the server buffer the whole manifest.
+		const auto too_long = fmt::format(R"({{"path": "{}", "size": 1}})", std::string(65 * 1024, 'x'));
+
+		const auto manifest = sandbox / "manifest.jsonl";
+		{
+			io::client::native_transport tp{conn};
+			io::odstream out{tp, manifest};
+			out << fmt::format(R"({{"path": "{}", "size": 3}})", first_object.c_str()) << '\n'
+				<< too_long << '\n'
+				<< "not json" << '\n'
+				<< R"({"size": 1})" << '\n'
+				<< '\n'
+				<< R"({"path": 5, "size": 1})" << '\n'
+				<< fmt::format(R"({{"path": "{}", "size": 5}})", second_object.c_str()) << '\n';
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, manifest.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = -1;
+		addKeyVal(&input.condInput, TRUNCATE_MANIFEST_KW, "");
+
+		nlohmann::json output;
+		CHECK(SYS_INVALID_INPUT_PARAM == unit_test_utils::replica_truncate(comm, input, output));
+
+		// The blank line is not an entry. Every other line is counted.
+		CHECK(6 == output.at("summary").at("matched").get<int>());
+		CHECK(2 == output.at("summary").at("truncated").get<int>());
+		CHECK(4 == output.at("summary").at("failed").get<int>());
+
+		const auto& failures = output.at("failures");
+		REQUIRE(4 == failures.size());
+		CHECK(std::string::npos != failures[0].at("message").get<std::string>().find("Line [2] is longer than"));
+		CHECK(std::string::npos != failures[1].at("message").get<std::string>().find("Line [3] is not valid JSON."));
+		CHECK(std::string::npos != failures[2].at("message").get<std::string>().find("Line [4]: Missing or invalid"));
+
+		// A path which is not a string is reported as a failure of its line, not as an error of the whole request.
+		CHECK(std::string::npos != failures[3].at("message").get<std::string>().find("Line [6]: Missing or invalid"));
+		CHECK(failures[3].at("path").get<std::string>().empty());
+
+		// The entries on either side of the bad lines were still truncated.
+		CHECK(3 == replica::replica_size(comm, first_object, 0));
+		CHECK(5 == replica::replica_size(comm, second_object, 0));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // manifest_lines_which_cannot_be_used_are_reported_and_skipped
+
+TEST_CASE("manifest_entries_without_permission_are_not_answered_from_the_catalog")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const std::string user_name = "test_truncate_manifest_user";
+		const std::string password = "rods";
+		unit_test_utils::add_rodsuser(comm, user_name, password);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_truncate_manifest_access";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		const auto user_home = fs::path{"/"} / env.rodsZone / "home" / user_name;
+		const auto manifest = user_home / "manifest.jsonl";
+
+		irods::at_scope_exit remove_sandbox{[&sandbox, &manifest, &user_name] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+
+			if (fs::client::exists(comm, manifest)) {
+				fs::client::remove(comm, manifest, fs::remove_options::no_trash);
+			}
+
+			unit_test_utils::remove_user(comm, user_name);
+		}};
+
+		// The other user has no permission on this data object, which already has the size its manifest asks for.
+		static constexpr auto contents = std::string_view{"0123456789"};
+		const auto target_object = sandbox / "target_object";
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		auto* user_comm = unit_test_utils::connect_as(user_name, password);
+		REQUIRE(user_comm);
+		irods::at_scope_exit disconnect{[user_comm] { rcDisconnect(user_comm); }};
+
+		{
+			io::client::native_transport tp{*user_comm};
+			io::odstream{tp, manifest}
+				<< fmt::format(R"({{"path": "{}", "size": {}}})", target_object.c_str(), contents.size()) << '\n';
+		}
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, manifest.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = -1;
+		addKeyVal(&input.condInput, TRUNCATE_MANIFEST_KW, "");
+
+		// The entry must fail the way a truncate of the data object would, rather than succeed because the catalog
+		// says that there is nothing to do.
+		nlohmann::json output;
+		CHECK(unit_test_utils::replica_truncate(*user_comm, input, output) < 0);
+		CHECK(1 == output.at("summary").at("matched").get<int>());
+		CHECK(0 == output.at("summary").at("truncated").get<int>());
+		CHECK(1 == output.at("summary").at("failed").get<int>());
+		CHECK(contents.size() == replica::replica_size(comm, target_object, 0));
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // manifest_entries_without_permission_are_not_answered_from_the_catalog
@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include "irods/client_connection.hpp"
+#include "irods/dataObjInpOut.h"
+#include "irods/dstream.hpp"
+#include "irods/filesystem.hpp"
+#include "irods/irods_at_scope_exit.hpp"
+#include "irods/irods_exception.hpp"
+#include "irods/objInfo.h"
+#include "irods/plugins/api/replica_truncate_common.h"
+#include "irods/rcMisc.h"
+#include "irods/replica.hpp"
+#include "irods/rodsClient.h"
+#include "irods/rodsDef.h"
+#include "irods/rodsErrorTable.h"
+#include "irods/transport/default_transport.hpp"
+#include "unit_test_utils.hpp"
+
+#include <fmt/format.h>
+
+#include <fcntl.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+// clang-format off
+namespace fs      = irods::experimental::filesystem;
+namespace io      = irods::experimental::io;
+namespace replica = irods::experimental::replica;
+// clang-format on
+
+TEST_CASE("wait_for_at_rest")
+{
+	try {
+		load_client_api_plugins();
+
+		irods::experimental::client_connection conn;
+		RcComm& comm = static_cast<RcComm&>(conn);
+
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		const auto sandbox = fs::path{env.rodsHome} / "test_wait_for_at_rest";
+		if (!fs::client::exists(comm, sandbox)) {
+			REQUIRE(fs::client::create_collection(comm, sandbox));
+		}
+
+		irods::at_scope_exit remove_sandbox{[&sandbox] {
+			irods::experimental::client_connection conn;
+			RcComm& comm = static_cast<RcComm&>(conn);
+
+			REQUIRE(fs::client::remove_all(comm, sandbox, fs::remove_options::no_trash));
+		}};
+
+		const auto target_object = sandbox / "target_object";
+
+		static constexpr auto contents = std::string_view{"0123456789"};
+
+		{
+			io::client::native_transport tp{conn};
+			io::odstream{tp, target_object} << contents;
+		}
+
+		// Open the object in read-write mode in order to lock the object.
+		DataObjInp doi{};
+		std::strncpy(doi.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		doi.openFlags = O_RDWR;
+
+		const auto fd = rcDataObjOpen(&comm, &doi);
+		REQUIRE(fd > 2);
+		REQUIRE(INTERMEDIATE_REPLICA == replica::replica_status(comm, target_object, 0));
+
+		bool closed = false;
+		const auto close_object = [&comm, fd, &closed] {
+			OpenedDataObjInp close_inp{};
+			close_inp.l1descInx = fd;
+			closed = 0 == rcDataObjClose(&comm, &close_inp);
+		};
+
+		irods::at_scope_exit close_if_open{[&closed, &close_object] {
+			if (!closed) {
+				close_object();
+			}
+		}};
+
+		irods::experimental::client_connection conn2;
+		RcComm& comm2 = static_cast<RcComm&>(conn2);
+
+		DataObjInp input{};
+		irods::at_scope_exit clear_input{[&input] { clearKeyVal(&input.condInput); }};
+		std::strncpy(input.objPath, target_object.c_str(), MAX_NAME_LEN - 1);
+		input.dataSize = 4;
+
+		SECTION("gives up once the timeout elapses")
+		{
+			addKeyVal(&input.condInput, TRUNCATE_WAIT_FOR_AT_REST_KW, "500");
+
+			const auto start = std::chrono::steady_clock::now();
+
+			nlohmann::json output;
+			CHECK(LOCKED_DATA_OBJECT_ACCESS == unit_test_utils::replica_truncate(comm2, input, output));
+			CHECK(std::string::npos != output.at("message").get<std::string>().find("Object is not at rest."));
+			CHECK(std::chrono::steady_clock::now() - start >= 500ms);
+
+			close_object();
+			REQUIRE(closed);
+
+			CHECK(contents.size() == replica::replica_size(comm, target_object, 0));
+		}
+
+		SECTION("proceeds once the replica comes to rest")
+		{
+			addKeyVal(&input.condInput, TRUNCATE_WAIT_FOR_AT_REST_KW, "30000");
+
+			// The first connection is only used by this thread until it is joined.
+			std::thread writer{[&close_object] {
+				std::this_thread::sleep_for(1s);
+				close_object();
+			}};
+
+			nlohmann::json output;
+			const auto ec = unit_test_utils::replica_truncate(comm2, input, output);
+
+			writer.join();
+			REQUIRE(closed);
+
+			CHECK(0 == ec);
+			CHECK(GOOD_REPLICA == replica::replica_status(comm, target_object, 0));
+			CHECK(4 == replica::replica_size(comm, target_object, 0));
+		}
+	}
+	catch (const irods::exception& e) {
+		fmt::print(stderr, "irods::exception occurred: [{}]", e.what());
+	}
+	catch (const std::exception& e) {
+		fmt::print(stderr, "std::exception occurred: [{}]", e.what());
+	}
+} // wait_for_at_rest
@@ -3,6 +3,7 @@
 
 #include "irods/dataObjRepl.h"
 #include "irods/filesystem/path.hpp"
+#include "irods/plugins/api/rc_replica_truncate.h"
 #include "irods/irods_at_scope_exit.hpp"
 #include "irods/irods_configuration_keywords.hpp"
 #include "irods/key_value_proxy.hpp"
@@ -10,9 +11,12 @@
 #include "irods/replica_close.h"
 #include "irods/resource_administration.hpp"
 #include "irods/rodsClient.h"
+#include "irods/user_administration.hpp"
 
 #include <boost/filesystem.hpp>
 
+#include <nlohmann/json.hpp>
+
 #include <unistd.h>
 
 #include <cstddef>
@@ -81,6 +85,26 @@ namespace unit_test_utils
 		adm::client::add_resource(_comm, ufs_info);
 	}
 
+	inline auto add_replication_resource(RcComm& _comm,
+	                                     const std::string_view _resc_name,
+	                                     const std::string_view _first_child,
+	                                     const std::string_view _second_child) -> void
+	{
+		namespace adm = irods::experimental::administration;
+
+		adm::resource_registration_info repl_info;
+		repl_info.resource_name = _resc_name.data();
+		repl_info.resource_type = adm::resource_type::replication;
+
+		adm::client::add_resource(_comm, repl_info);
+
+		add_ufs_resource(_comm, _first_child, std::string{_first_child} + "_vault");
+		add_ufs_resource(_comm, _second_child, std::string{_second_child} + "_vault");
+
+		adm::client::add_child_resource(_comm, _resc_name, _first_child);
+		adm::client::add_child_resource(_comm, _resc_name, _second_child);
+	} // add_replication_resource
+
 	inline auto replicate_data_object(RcComm& _comm, const std::string_view _path, const std::string_view _resc_name)
 		-> bool
 	{
@@ -132,6 +156,21 @@ namespace unit_test_utils
 		return true;
 	}
 
+	// Calls the replica truncate API and parses its output. _output is left empty if the server sent none.
+	inline auto replica_truncate(RcComm& _comm, DataObjInp& _input, nlohmann::json& _output) -> int
+	{
+		BytesBuf* output{};
+		irods::at_scope_exit free_output{[&output] { freeBBuf(output); }};
+
+		const auto ec = rc_replica_truncate(&_comm, &_input, &output);
+
+		if (output && output->buf && output->len > 0) {
+			_output = nlohmann::json::parse(static_cast<char*>(output->buf));
+		}
+
+		return ec;
+	} // replica_truncate
+
 	inline auto get_agent_pid(RcComm& _comm) -> int
 	{
 		ExecMyRuleInp inp{};
@@ -166,6 +205,46 @@ namespace unit_test_utils
 			return -3;
 		}
 	} // get_agent_pid
+
+	inline auto add_rodsuser(RcComm& _comm, const std::string_view _user_name, const std::string_view _password)
+		-> void
+	{
+		namespace adm = irods::experimental::administration;
+
+		const adm::user user{std::string{_user_name}};
+
+		adm::client::add_user(_comm, user);
+		adm::client::modify_user(_comm, user, adm::user_password_property{std::string{_password}});
+	} // add_rodsuser
+
+	inline auto remove_user(RcComm& _comm, const std::string_view _user_name) -> void
+	{
+		namespace adm = irods::experimental::administration;
+
+		adm::client::remove_user(_comm, adm::user{std::string{_user_name}});
+	} // remove_user
+
+	// Connects to the server in the client's environment as another user of its zone. Returns nullptr if the user
+	// cannot connect or log in. Release the connection with rcDisconnect.
+	inline auto connect_as(const std::string_view _user_name, const std::string_view _password) -> RcComm*
+	{
+		rodsEnv env;
+		_getRodsEnv(env);
+
+		rErrMsg_t error{};
+		auto* comm = rcConnect(env.rodsHost, env.rodsPort, std::string{_user_name}.c_str(), env.rodsZone, 0, &error);
+		if (!comm) {
+			return nullptr;
+		}
+
+		auto password = std::string{_password};
+		if (clientLoginWithPassword(comm, password.data()) < 0) {
+			rcDisconnect(comm);
+			return nullptr;
+		}
+
+		return comm;
+	} // connect_as
 } // namespace unit_test_utils
 
 #endif // IRODS_UNIT_TEST_UTILS_HPP